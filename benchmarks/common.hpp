@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "perf.hpp"
+
+namespace bench {
+
+/**
+ * Command-line options shared by all benchmark executables
+ **/
+struct options {
+    size_t min_size = 1000;
+    size_t max_size = 100000000;
+    double time_budget = 0.2; // seconds spent per measurement (at least one run)
+    size_t max_repetitions = 100;
+    std::string algorithms; // comma-separated substrings, empty for all
+    std::string distributions; // comma-separated names, empty for all
+    std::string type = "int";
+    unsigned seed = 42;
+    bool perf = false; // collect hardware performance counters
+    bool latency = false; // collect per-operation latency histograms
+};
+
+inline void print_usage(const char *name, const options& defaults, std::ostream& out) {
+    out << "Usage: " << name << " [options]" << std::endl
+        << "    --min-size N          smallest input size (default " << defaults.min_size << ")" << std::endl
+        << "    --max-size N          largest input size (default " << defaults.max_size << ")" << std::endl
+        << "    --time-budget S       seconds per measurement (default " << defaults.time_budget << ")" << std::endl
+        << "    --max-repetitions N   repetitions per measurement (default " << defaults.max_repetitions << ")" << std::endl
+        << "    --algorithms A,B      run only algorithms containing A or B" << std::endl
+        << "    --distributions A,B   run only listed input distributions" << std::endl
+        << "    --type T              value type: int or double (default " << defaults.type << ")" << std::endl
+        << "    --seed N              random seed (default " << defaults.seed << ")" << std::endl
+        << "    --perf                collect hardware performance counters" << std::endl
+        << "    --latency             collect per-operation latency histograms" << std::endl;
+}
+
+/**
+ * Parse command-line options over benchmark-specific defaults
+ **/
+inline options parse_options(int argc, char **argv, options opts = options()) {
+    const options defaults = opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0], defaults, std::cout);
+            std::exit(0);
+        }
+        if (arg == "--perf") {
+            opts.perf = true;
+            continue;
+        }
+        if (arg == "--latency") {
+            opts.latency = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            print_usage(argv[0], defaults, std::cerr);
+            std::exit(1);
+        }
+        std::string value = argv[++i];
+        if (arg == "--min-size")
+            opts.min_size = size_t(std::stod(value));
+        else if (arg == "--max-size")
+            opts.max_size = size_t(std::stod(value));
+        else if (arg == "--time-budget")
+            opts.time_budget = std::stod(value);
+        else if (arg == "--max-repetitions")
+            opts.max_repetitions = std::stoul(value);
+        else if (arg == "--algorithms")
+            opts.algorithms = value;
+        else if (arg == "--distributions")
+            opts.distributions = value;
+        else if (arg == "--type")
+            opts.type = value;
+        else if (arg == "--seed")
+            opts.seed = unsigned(std::stoul(value));
+        else {
+            print_usage(argv[0], defaults, std::cerr);
+            std::exit(1);
+        }
+    }
+    return opts;
+}
+
+/**
+ * Remove a benchmark-specific `name value` option from argv before
+ * parse_options and return its value, `fallback` if not given
+ **/
+inline std::string take_option(int& argc, char **argv, const std::string& name, const std::string& fallback) {
+    std::string value = fallback;
+    for (int i = 1; i + 1 < argc;) {
+        if (argv[i] != name) {
+            ++i;
+            continue;
+        }
+        value = argv[i + 1];
+        for (int j = i; j + 2 < argc; ++j)
+            argv[j] = argv[j + 2];
+        argc -= 2;
+    }
+    return value;
+}
+
+/**
+ * Check if a name is selected by a comma-separated filter. Empty filter
+ * selects everything, `exact` requires a full match instead of a substring
+ **/
+inline bool selected(const std::string& filter, const std::string& name, bool exact = false) {
+    if (filter.empty())
+        return true;
+    std::istringstream in(filter);
+    for (std::string item; std::getline(in, item, ',');)
+        if (exact ? name == item : name.find(item) != std::string::npos)
+            return true;
+    return false;
+}
+
+/**
+ * Decimal sizes from min to max: 1e3, 1e4, ...
+ **/
+inline std::vector<size_t> decimal_sizes(size_t min, size_t max) {
+    std::vector<size_t> sizes;
+    for (size_t size = 1; size <= max; size *= 10)
+        if (size >= min)
+            sizes.push_back(size);
+    return sizes;
+}
+
+using clock = std::chrono::steady_clock;
+
+inline double seconds_since(clock::time_point start) {
+    return std::chrono::duration<double>(clock::now() - start).count();
+}
+
+/**
+ * Prevent a compiler from optimizing away a computed value
+ **/
+template<typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * Bytes currently allocated from the heap, 0 if unknown
+ **/
+inline size_t heap_in_use() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Timings of repeated runs of the same measurement
+ **/
+struct timings {
+    std::vector<double> seconds;
+
+    double min() const {
+        return *std::min_element(seconds.begin(), seconds.end());
+    }
+
+    double median() {
+        std::sort(seconds.begin(), seconds.end());
+        size_t mid = seconds.size() / 2;
+        return seconds.size() % 2 ? seconds[mid] : (seconds[mid-1] + seconds[mid]) / 2;
+    }
+};
+
+/**
+ * Repeat `prepare` (not timed) and `run` (timed) until a time budget
+ * or a repetition limit is exhausted. Always runs at least once.
+ * If `counters` are given, they accumulate over all runs of `run`
+ **/
+template<typename Prepare, typename Run>
+timings measure(const options& opts, Prepare prepare, Run run, perf_counters *counters = nullptr) {
+    timings result;
+    double total = 0;
+    if (counters)
+        counters->reset();
+    while (result.seconds.empty() ||
+            (total < opts.time_budget && result.seconds.size() < opts.max_repetitions)) {
+        prepare();
+        if (counters)
+            counters->start();
+        auto start = clock::now();
+        run();
+        double elapsed = seconds_since(start);
+        if (counters)
+            counters->stop();
+        result.seconds.push_back(elapsed);
+        total += elapsed;
+    }
+    return result;
+}
+
+/**
+ * One flat JSON object with preformatted values
+ **/
+class record {
+public:
+    record& add(const std::string& key, const std::string& value) {
+        mFields.emplace_back(key, quote(value));
+        return *this;
+    }
+
+    record& add(const std::string& key, const char *value) {
+        return add(key, std::string(value));
+    }
+
+    record& add(const std::string& key, bool value) {
+        mFields.emplace_back(key, value ? "true" : "false");
+        return *this;
+    }
+
+    template<typename T>
+    std::enable_if_t<std::is_arithmetic_v<T>, record&>
+    add(const std::string& key, T value) {
+        std::ostringstream out;
+        if constexpr(std::is_floating_point_v<T>) {
+            if (value != value || value == std::numeric_limits<T>::infinity()) {
+                mFields.emplace_back(key, "null");
+                return *this;
+            }
+            out.precision(6);
+            out << std::fixed;
+        }
+        out << value;
+        mFields.emplace_back(key, out.str());
+        return *this;
+    }
+
+    // NOTE: `json` is written as is
+    record& add_json(const std::string& key, const std::string& json) {
+        mFields.emplace_back(key, json);
+        return *this;
+    }
+
+    record& append(const record& other) {
+        mFields.insert(mFields.end(), other.mFields.begin(), other.mFields.end());
+        return *this;
+    }
+
+    void write(std::ostream& out) const {
+        out << '{';
+        for (size_t i = 0; i < mFields.size(); ++i)
+            out << (i ? ", " : "") << quote(mFields[i].first) << ": " << mFields[i].second;
+        out << '}';
+    }
+
+    static std::string quote(const std::string& value) {
+        std::string out = "\"";
+        for (char c : value) {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        return out + '"';
+    }
+
+private:
+    std::vector<std::pair<std::string, std::string>> mFields;
+};
+
+/**
+ * Benchmark report: a header record and a list of result records,
+ * written as a single JSON document
+ **/
+class report {
+public:
+    explicit report(const std::string& name) {
+        mHeader.add("benchmark", name)
+            .add("compiler", __VERSION__)
+            .add("timestamp", long(std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count()));
+    }
+
+    record& header() {
+        return mHeader;
+    }
+
+    void add(const record& result) {
+        mResults.push_back(result);
+    }
+
+    void write(std::ostream& out) const {
+        out << "{\n    \"header\": ";
+        mHeader.write(out);
+        out << ",\n    \"results\": [";
+        for (size_t i = 0; i < mResults.size(); ++i) {
+            out << (i ? ",\n        " : "\n        ");
+            mResults[i].write(out);
+        }
+        out << "\n    ]\n}" << std::endl;
+    }
+
+private:
+    record mHeader;
+    std::vector<record> mResults;
+};
+
+} // namespace bench
@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace bench {
+
+/**
+ * Cheap timestamps for per-operation latencies: TSC on x86
+ * (a few ns per read), steady_clock nanoseconds elsewhere
+ **/
+class latency_timer {
+public:
+    static uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    /**
+     * Nanoseconds per tick, calibrated once against steady_clock
+     **/
+    static double ns_per_tick() {
+        static const double value = calibrate();
+        return value;
+    }
+
+private:
+    static double calibrate() {
+#if defined(__x86_64__) || defined(__i386__)
+        auto start = std::chrono::steady_clock::now();
+        uint64_t ticks = now();
+        while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(20));
+        ticks = now() - ticks;
+        double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        return ticks ? ns / ticks : 1.;
+#else
+        return 1.;
+#endif
+    }
+};
+
+/**
+ * HDR-style latency histogram: each power of two range is split into
+ * 2^SubBits linear buckets, so values are kept with a relative error
+ * of at most 2^-SubBits (3% for the default) over the whole uint64 range.
+ * Recording is a count-leading-zeros and an increment; the `Outliers`
+ * largest samples are kept with their sequence numbers.
+ * NOTE: Values are in arbitrary units (see latency_timer)
+ **/
+template<unsigned SubBits = 5, size_t Outliers = 8>
+class latency_histogram {
+public:
+    static constexpr uint64_t SUB_BUCKETS = uint64_t(1) << SubBits;
+    static constexpr size_t BUCKETS = (64 - SubBits + 1) * SUB_BUCKETS;
+
+    latency_histogram()
+        : mCounts(BUCKETS, 0), mCount(0), mSum(0), mMin(UINT64_MAX), mMax(0)
+    {}
+
+    void record(uint64_t value) {
+        ++mCounts[index(value)];
+        mSum += value;
+        mMin = std::min(mMin, value);
+        mMax = std::max(mMax, value);
+        if (mOutliers.size() < Outliers || mOutliers.front().first < value)
+            record_outlier(value);
+        ++mCount;
+    }
+
+    /**
+     * Time a call of `fn` and record its duration in latency_timer ticks
+     **/
+    template<typename Fn>
+    void time(Fn fn) {
+        uint64_t start = latency_timer::now();
+        fn();
+        record(latency_timer::now() - start);
+    }
+
+    uint64_t count() const {
+        return mCount;
+    }
+
+    uint64_t min() const {
+        return mCount ? mMin : 0;
+    }
+
+    uint64_t max() const {
+        return mMax;
+    }
+
+    double mean() const {
+        return mCount ? double(mSum) / mCount : 0.;
+    }
+
+    /**
+     * Smallest recorded bucket's upper bound such that `p` percent
+     * of values are less than or equal to it
+     **/
+    uint64_t percentile(double p) const {
+        if (mCount == 0)
+            return 0;
+        uint64_t rank = uint64_t(std::ceil(p / 100. * mCount));
+        rank = std::max<uint64_t>(rank, 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += mCounts[i];
+            if (seen >= rank)
+                return std::min(upper_bound(i), mMax);
+        }
+        return mMax;
+    }
+
+    /**
+     * Largest values with their sequence numbers, largest first
+     **/
+    std::vector<std::pair<uint64_t, uint64_t>> outliers() const {
+        auto result = mOutliers;
+        std::sort(result.begin(), result.end(), std::greater<>());
+        return result;
+    }
+
+    void merge(const latency_histogram& other) {
+        for (size_t i = 0; i < BUCKETS; ++i)
+            mCounts[i] += other.mCounts[i];
+        for (const auto& outlier : other.mOutliers)
+            if (mOutliers.size() < Outliers || mOutliers.front().first < outlier.first)
+                record_outlier(outlier.first, outlier.second + mCount);
+        mCount += other.mCount;
+        mSum += other.mSum;
+        mMin = std::min(mMin, other.mMin);
+        mMax = std::max(mMax, other.mMax);
+    }
+
+    void clear() {
+        *this = latency_histogram();
+    }
+
+    /**
+     * Percentiles reported by add_to and print
+     **/
+    static std::vector<std::pair<const char *, double>> percentiles() {
+        return { { "p50", 50. }, { "p90", 90. }, { "p99", 99. }, { "p999", 99.9 }, { "p9999", 99.99 } };
+    }
+
+    /**
+     * Add percentiles, maximum and outliers scaled by `scale` (e.g. ns per
+     * tick) to a record as `<prefix>p50` ... `<prefix>max`, `<prefix>outliers`
+     **/
+    template<typename Record>
+    void add_to(Record& record, const std::string& prefix, double scale) const {
+        for (const auto& p : percentiles())
+            record.add(prefix + p.first, percentile(p.second) * scale);
+        record.add(prefix + "max", max() * scale);
+        std::ostringstream out;
+        out << '[';
+        auto values = outliers();
+        for (size_t i = 0; i < values.size(); ++i)
+            out << (i ? ", " : "") << "{\"op\": " << values[i].second
+                << ", \"value\": " << values[i].first * scale << '}';
+        out << ']';
+        record.add_json(prefix + "outliers", out.str());
+    }
+
+    /**
+     * Print a percentile table scaled by `scale`
+     **/
+    void print(std::ostream& out, double scale) const {
+        out << "    count " << count() << ", mean " << mean() * scale
+            << ", min " << min() * scale << std::endl;
+        for (const auto& p : percentiles())
+            out << "    " << std::setw(6) << p.first << ' ' << percentile(p.second) * scale << std::endl;
+        out << "    " << std::setw(6) << "max" << ' ' << max() * scale << std::endl;
+    }
+
+private:
+    static size_t index(uint64_t value) {
+        if (value < SUB_BUCKETS)
+            return size_t(value);
+        unsigned msb = 63 - unsigned(__builtin_clzll(value));
+        unsigned shift = msb - SubBits;
+        return size_t((shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1)));
+    }
+
+    static uint64_t upper_bound(size_t index) {
+        if (index < SUB_BUCKETS)
+            return index;
+        uint64_t shift = index / SUB_BUCKETS - 1;
+        uint64_t sub = index % SUB_BUCKETS;
+        return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+    }
+
+    // min-heap on values, so the smallest outlier is replaced first
+    void record_outlier(uint64_t value, uint64_t sequence) {
+        auto greater = std::greater<>();
+        if (mOutliers.size() == Outliers) {
+            std::pop_heap(mOutliers.begin(), mOutliers.end(), greater);
+            mOutliers.pop_back();
+        }
+        mOutliers.emplace_back(value, sequence);
+        std::push_heap(mOutliers.begin(), mOutliers.end(), greater);
+    }
+
+    void record_outlier(uint64_t value) {
+        record_outlier(value, mCount);
+    }
+
+    std::vector<uint64_t> mCounts;
+    uint64_t mCount, mSum, mMin, mMax;
+    std::vector<std::pair<uint64_t, uint64_t>> mOutliers; // (value, sequence number)
+};
+
+} // namespace bench
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace bench {
+
+/**
+ * Zipfian distribution over [0, n): rank i is drawn with probability
+ * proportional to 1/(i+1)^theta. Gray et al. "Quickly generating
+ * billion-record synthetic databases", as used by YCSB.
+ * NOTE: Construction is O(n), drawing is O(1)
+ **/
+class zipfian {
+public:
+    zipfian(uint64_t n, double theta = 0.99)
+        : mN(n), mTheta(theta)
+    {
+        mZetaN = zeta(n, theta);
+        double zeta2 = zeta(2, theta);
+        mAlpha = 1. / (1. - theta);
+        mEta = (1. - std::pow(2. / n, 1. - theta)) / (1. - zeta2 / mZetaN);
+        mHalfPowTheta = 1. + std::pow(.5, theta);
+    }
+
+    template<typename Generator>
+    uint64_t operator()(Generator& gen) {
+        double u = std::uniform_real_distribution<double>(0., 1.)(gen);
+        double uz = u * mZetaN;
+        if (uz < 1.)
+            return 0;
+        if (uz < mHalfPowTheta)
+            return 1;
+        uint64_t rank = uint64_t(mN * std::pow(mEta * u - mEta + 1., mAlpha));
+        return std::min(rank, mN - 1);
+    }
+
+private:
+    static double zeta(uint64_t n, double theta) {
+        double sum = 0;
+        for (uint64_t i = 1; i <= n; ++i)
+            sum += 1. / std::pow(double(i), theta);
+        return sum;
+    }
+
+    uint64_t mN;
+    double mTheta, mZetaN, mAlpha, mEta, mHalfPowTheta;
+};
+
+/**
+ * Spread popular ranks over a key space, so hot keys are not
+ * the smallest ones (FNV-1a of a rank)
+ **/
+inline uint64_t scramble(uint64_t rank, uint64_t n) {
+    uint64_t hash = 14695981039346656037ull;
+    for (int i = 0; i < 8; ++i) {
+        hash ^= (rank >> (i * 8)) & 0xff;
+        hash *= 1099511628211ull;
+    }
+    return hash % n;
+}
+
+/**
+ * Key streams for container benchmarks. All keys are in [0, n)
+ **/
+template<typename Key>
+std::vector<Key> sequential_keys(size_t n) {
+    std::vector<Key> keys(n);
+    std::iota(keys.begin(), keys.end(), Key(0));
+    return keys;
+}
+
+template<typename Key>
+std::vector<Key> random_keys(size_t n, std::mt19937& gen) {
+    auto keys = sequential_keys<Key>(n);
+    std::shuffle(keys.begin(), keys.end(), gen);
+    return keys;
+}
+
+// NOTE: contains duplicates, popular keys are scrambled over [0, n)
+template<typename Key>
+std::vector<Key> zipfian_keys(size_t n, std::mt19937& gen, double theta = 0.99) {
+    zipfian dis(n, theta);
+    std::vector<Key> keys(n);
+    for (auto& key : keys)
+        key = Key(scramble(dis(gen), n));
+    return keys;
+}
+
+// runs of `cluster` consecutive keys, runs are in random order
+template<typename Key>
+std::vector<Key> clustered_keys(size_t n, std::mt19937& gen, size_t cluster = 64) {
+    std::vector<size_t> starts;
+    for (size_t start = 0; start < n; start += cluster)
+        starts.push_back(start);
+    std::shuffle(starts.begin(), starts.end(), gen);
+    std::vector<Key> keys;
+    keys.reserve(n);
+    for (auto start : starts)
+        for (size_t key = start; key < std::min(start + cluster, n); ++key)
+            keys.push_back(Key(key));
+    return keys;
+}
+
+} // namespace bench
@@ -0,0 +1,164 @@
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+/**
+ * Hardware performance counters of the calling thread, read through
+ * perf_event_open(2). Each event is opened separately, so unsupported
+ * events (VMs, perf_event_paranoid, non-Linux systems) are reported as
+ * unavailable without affecting the others. Values are scaled if the
+ * kernel multiplexed events
+ **/
+class perf_counters {
+public:
+    struct event {
+        const char *name;
+        uint32_t type;
+        uint64_t config;
+    };
+
+    static std::vector<event> events() {
+#ifdef __linux__
+        auto cache = [](uint64_t cache, uint64_t op, uint64_t result) {
+            return cache | (op << 8) | (result << 16);
+        };
+        return {
+            { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { "branches", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+            { "branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+            { "l1d_misses", PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_L1D,
+                PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+            { "llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+            { "dtlb_misses", PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_DTLB,
+                PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+        };
+#else
+        return {};
+#endif
+    }
+
+    perf_counters() {
+        for (const auto& e : events())
+            mFds.push_back(open(e));
+    }
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    ~perf_counters() {
+#ifdef __linux__
+        for (int fd : mFds)
+            if (fd >= 0)
+                close(fd);
+#endif
+    }
+
+    /**
+     * Check if at least one counter could be opened
+     **/
+    bool available() const {
+        for (int fd : mFds)
+            if (fd >= 0)
+                return true;
+        return false;
+    }
+
+    void reset() {
+        control(RESET);
+    }
+
+    // NOTE: start-stop periods accumulate until reset
+    void start() {
+        control(ENABLE);
+    }
+
+    void stop() {
+        control(DISABLE);
+    }
+
+    /**
+     * Counter values accumulated since reset, negative if unavailable
+     **/
+    std::vector<double> read() const {
+        std::vector<double> values;
+        for (int fd : mFds)
+            values.push_back(read(fd));
+        return values;
+    }
+
+    /**
+     * Add counter values divided by `divisor` (elements or operations)
+     * to a record as `<prefix><counter>`, unavailable counters as null
+     **/
+    template<typename Record>
+    void add_to(Record& record, const std::string& prefix, double divisor) const {
+        auto names = events();
+        auto values = read();
+        for (size_t i = 0; i < names.size(); ++i)
+            record.add(prefix + names[i].name, values[i] < 0 ?
+                std::numeric_limits<double>::quiet_NaN() : values[i] / divisor);
+    }
+
+private:
+    enum command { RESET, ENABLE, DISABLE };
+
+    static int open(const event& e) {
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = e.type;
+        attr.config = e.config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+        (void)e;
+        return -1;
+#endif
+    }
+
+    void control(command cmd) {
+#ifdef __linux__
+        unsigned long request = cmd == RESET ? PERF_EVENT_IOC_RESET :
+            cmd == ENABLE ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE;
+        for (int fd : mFds)
+            if (fd >= 0)
+                ioctl(fd, request, 0);
+#else
+        (void)cmd;
+#endif
+    }
+
+    static double read(int fd) {
+#ifdef __linux__
+        uint64_t data[3]; // value, time enabled, time running
+        if (fd < 0 || ::read(fd, data, sizeof(data)) != sizeof(data))
+            return -1;
+        if (data[2] == 0) // never scheduled on a PMU
+            return data[1] == 0 ? 0 : -1;
+        return double(data[0]) * double(data[1]) / double(data[2]);
+#else
+        (void)fd;
+        return -1;
+#endif
+    }
+
+    std::vector<int> mFds;
+};
+
+} // namespace bench
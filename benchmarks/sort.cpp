@@ -0,0 +1,239 @@
+#include "common.hpp"
+#include "helpers/generators.hpp"
+#include "helpers/stack_depth.hpp"
+#include "algs/sort/selection.hpp"
+#include "algs/sort/insertion.hpp"
+#include "algs/sort/shell.hpp"
+#include "algs/sort/merge.hpp"
+#include "algs/sort/heap.hpp"
+#include "algs/sort/quicksort.hpp"
+#include "algs/sort/parallel.hpp"
+
+namespace {
+    const size_t UNLIMITED = std::numeric_limits<size_t>::max();
+
+    // inputs larger than this are not generated against an adversary or probed for stack usage
+    const size_t MAX_INSTRUMENTED_SIZE = 1000000;
+
+    /**
+     * Input distributions: shapes from tests/helpers/generators.hpp and
+     * "antiqsort", built separately for each algorithm by McIlroy's adversary
+     **/
+    template<typename Iter>
+    struct Distribution {
+        const char *name;
+        void (*fill)(Iter, Iter, std::mt19937&); // nullptr for antiqsort
+        bool adversarial; // degrades naive quicksorts
+    };
+
+    template<typename Iter>
+    std::vector<Distribution<Iter>> distributions() {
+        std::vector<Distribution<Iter>> result;
+        for (const auto& input : helpers::inputs<Iter>())
+            result.push_back({ input.name, input.fill, input.adversarial });
+        result.push_back({ "antiqsort", nullptr, true });
+        return result;
+    }
+
+    template<typename Iter>
+    using IterSortFn = void (*)(Iter, Iter);
+
+    /**
+     * A benchmarked sort. Quadratic algorithms are capped by `max_size`,
+     * algorithms with quadratic worst case (and recursion as deep
+     * as input size) are capped by `max_size_adversarial` on
+     * non-random inputs. Partitioning and selection routines are benchmarked
+     * the same way, but their output is not checked to be sorted
+     **/
+    template<typename Iter>
+    struct Algorithm {
+        const char *name;
+        IterSortFn<Iter> sort;
+        size_t max_size;
+        size_t max_size_adversarial;
+        bool sorts = true;
+    };
+
+    template<typename Iter>
+    std::vector<Algorithm<Iter>> algorithms() {
+        return {
+            { "std::sort", [](Iter b, Iter e) { std::sort(b, e); }, UNLIMITED, UNLIMITED },
+            { "std::stable_sort", [](Iter b, Iter e) { std::stable_sort(b, e); }, UNLIMITED, UNLIMITED },
+            { "selection::sort", algs::sort::selection::sort, 10000, 10000 },
+            { "selection::sort_stl", algs::sort::selection::sort_stl, 10000, 10000 },
+            { "insertion::sort", algs::sort::insertion::sort, 10000, 10000 },
+            { "insertion::sort_enhanced", algs::sort::insertion::sort_enhanced, 10000, 10000 },
+            { "shell::sort", algs::sort::shell::sort, 10000000, 10000000 },
+            { "heap::sort", algs::sort::heap::sort, UNLIMITED, UNLIMITED },
+            { "std::partial_sort", [](Iter b, Iter e) { std::partial_sort(b, b + (e - b) / 100, e); },
+                UNLIMITED, UNLIMITED, false },
+            { "heap::partial_sort", [](Iter b, Iter e) { algs::sort::heap::partial_sort(b, b + (e - b) / 100, e); },
+                UNLIMITED, UNLIMITED, false },
+            { "heap::top_k", [](Iter b, Iter e) { algs::sort::heap::top_k(b, e, size_t(e - b) / 100); },
+                UNLIMITED, UNLIMITED, false },
+            { "merge::sort_recursive", algs::sort::merge::sort_recursive, UNLIMITED, UNLIMITED },
+            { "merge::sort_recursive_inplace", algs::sort::merge::sort_recursive_inplace, 100000, 100000 },
+            { "merge::sort_bottomup", algs::sort::merge::sort_bottomup, UNLIMITED, UNLIMITED },
+            { "merge::sort_bottomup (scratch)", [](Iter b, Iter e) {
+                    // one buffer reused by all runs, as in a loop of repeated sorts
+                    static algs::sort::scratch_buffer<typename std::iterator_traits<Iter>::value_type> scratch;
+                    algs::sort::merge::sort_bottomup(b, e, scratch);
+                }, UNLIMITED, UNLIMITED },
+            { "merge::sort_bottomup_pingpong (scratch)", [](Iter b, Iter e) {
+                    static algs::sort::scratch_buffer<typename std::iterator_traits<Iter>::value_type> scratch;
+                    algs::sort::merge::sort_bottomup_pingpong(b, e, scratch);
+                }, UNLIMITED, UNLIMITED },
+            { "merge::sort_bottomup_pingpong (huge pages)", [](Iter b, Iter e) {
+                    static algs::sort::scratch_buffer<typename std::iterator_traits<Iter>::value_type> scratch(true);
+                    algs::sort::merge::sort_bottomup_pingpong(b, e, scratch);
+                }, UNLIMITED, UNLIMITED },
+            { "merge::sort_recursive_pingpong", algs::sort::merge::sort_recursive_pingpong, UNLIMITED, UNLIMITED },
+            { "merge::sort_bottomup_pingpong", algs::sort::merge::sort_bottomup_pingpong, UNLIMITED, UNLIMITED },
+            { "merge::sort_natural", algs::sort::merge::sort_natural, UNLIMITED, UNLIMITED },
+            { "merge::sort_block_merge", algs::sort::merge::sort_block_merge, UNLIMITED, UNLIMITED },
+            { "merge::sort_bottomup_inplace", algs::sort::merge::sort_bottomup_inplace, 10000, 10000 },
+            { "quicksort::sort", algs::sort::quicksort::sort, UNLIMITED, 10000 },
+            { "quicksort::introsort", algs::sort::quicksort::introsort, UNLIMITED, UNLIMITED },
+            { "quicksort::sort_three_way", algs::sort::quicksort::sort_three_way, UNLIMITED, 100000 },
+            { "quicksort::pdqsort", algs::sort::quicksort::pdqsort, UNLIMITED, UNLIMITED },
+            { "quicksort::sort_dual_pivot", algs::sort::quicksort::sort_dual_pivot, UNLIMITED, 100000 },
+            { "quicksort::partition", [](Iter b, Iter e) { algs::sort::quicksort::partition(b, e); },
+                UNLIMITED, UNLIMITED, false },
+            { "quicksort::partition_vectorized", [](Iter b, Iter e) { algs::sort::quicksort::partition_vectorized(b, e); },
+                UNLIMITED, UNLIMITED, false },
+            { "quicksort::partition_dual_pivot", [](Iter b, Iter e) { algs::sort::quicksort::partition_dual_pivot(b, e); },
+                UNLIMITED, UNLIMITED, false },
+            { "quicksort::partition_three_way", [](Iter b, Iter e) { algs::sort::quicksort::partition_three_way(b, e); },
+                UNLIMITED, UNLIMITED, false },
+            { "quicksort::select", [](Iter b, Iter e) { algs::sort::quicksort::select(b, e, size_t(e - b) / 2); },
+                UNLIMITED, 10000, false },
+            { "quicksort::introselect", [](Iter b, Iter e) { algs::sort::quicksort::introselect(b, e, size_t(e - b) / 2); },
+                UNLIMITED, UNLIMITED, false },
+            { "quicksort::select_median_of_medians",
+                [](Iter b, Iter e) { algs::sort::quicksort::select_median_of_medians(b, e, size_t(e - b) / 2); },
+                UNLIMITED, UNLIMITED, false },
+            { "quicksort::multi_select", [](Iter b, Iter e) {
+                    size_t n = size_t(e - b);
+                    algs::sort::quicksort::multi_select(b, e, { n / 2, n * 9 / 10, n * 99 / 100, n * 999 / 1000 });
+                }, UNLIMITED, UNLIMITED, false },
+            { "quicksort::select_floyd_rivest",
+                [](Iter b, Iter e) { algs::sort::quicksort::select_floyd_rivest(b, e, size_t(e - b) / 2); },
+                UNLIMITED, 100000, false },
+            { "parallel::merge_sort", [](Iter b, Iter e) { algs::sort::parallel::merge_sort(b, e); },
+                UNLIMITED, UNLIMITED },
+            { "parallel::partition", [](Iter b, Iter e) { algs::sort::parallel::partition(b, e); },
+                UNLIMITED, UNLIMITED, false },
+            { "parallel::select", [](Iter b, Iter e) { algs::sort::parallel::select(b, e, size_t(e - b) / 2); },
+                UNLIMITED, UNLIMITED, false },
+        };
+    }
+
+    /**
+     * Peak stack bytes used by `sort` on a copy of `original`
+     **/
+    template<typename T>
+    size_t stack_bytes(const std::vector<T>& original,
+                       IterSortFn<typename std::vector<helpers::probed<T>>::iterator> sort) {
+        std::vector<helpers::probed<T>> probed(original.begin(), original.end());
+        return helpers::stack_depth::measure([&] { sort(probed.begin(), probed.end()); });
+    }
+
+    template<typename T>
+    void run(const bench::options& opts, bench::report& report) {
+        using Iter = typename std::vector<T>::iterator;
+        using ItemIter = std::vector<helpers::antiqsort::item>::iterator;
+        using ProbedIter = typename std::vector<helpers::probed<T>>::iterator;
+        // the same algorithms instantiated for the adversary and stack probes
+        auto algs = algorithms<Iter>();
+        auto adversary_algs = algorithms<ItemIter>();
+        auto probed_algs = algorithms<ProbedIter>();
+        bench::perf_counters counters;
+        bench::perf_counters *pCounters = opts.perf ? &counters : nullptr;
+        if (opts.perf && !counters.available())
+            std::cerr << "Performance counters are not available" << std::endl;
+
+        for (auto size : bench::decimal_sizes(opts.min_size, opts.max_size)) {
+            for (const auto& dist : distributions<Iter>()) {
+                if (!bench::selected(opts.distributions, dist.name, true))
+                    continue;
+                if (!dist.fill && size > MAX_INSTRUMENTED_SIZE)
+                    continue;
+
+                std::mt19937 gen(opts.seed);
+                std::vector<T> original(size);
+                if (dist.fill)
+                    dist.fill(original.begin(), original.end(), gen);
+                std::vector<T> work(size);
+
+                double reference = 0; // std::sort median, baseline for comparison
+                for (size_t i = 0; i < algs.size(); ++i) {
+                    const auto& alg = algs[i];
+                    bool is_reference = std::strcmp(alg.name, "std::sort") == 0;
+                    if (!is_reference && !bench::selected(opts.algorithms, alg.name))
+                        continue;
+                    if (size > (dist.adversarial ? alg.max_size_adversarial : alg.max_size))
+                        continue;
+                    // NOTE: each algorithm gets its own adversarial input,
+                    //       so std::sort is a baseline of the same difficulty
+                    if (!dist.fill)
+                        original = helpers::antiqsort_input<T>(size, adversary_algs[i].sort);
+
+                    auto t = bench::measure(opts,
+                        [&] { std::copy(original.begin(), original.end(), work.begin()); },
+                        [&] { alg.sort(work.begin(), work.end()); },
+                        pCounters);
+                    bool sorted = !alg.sorts || std::is_sorted(work.begin(), work.end());
+                    double median = t.median();
+                    if (is_reference)
+                        reference = median;
+                    double stack = size <= MAX_INSTRUMENTED_SIZE ?
+                        double(stack_bytes<T>(original, probed_algs[i].sort)) :
+                        std::numeric_limits<double>::quiet_NaN();
+
+                    std::cerr << alg.name << ' ' << dist.name << ' ' << size << ": "
+                        << median * 1e9 / size << " ns/element, "
+                        << stack << " stack bytes"
+                        << (sorted ? "" : " (NOT SORTED)") << std::endl;
+
+                    bench::record result;
+                    result.add("algorithm", alg.name)
+                        .add("distribution", dist.name)
+                        .add("size", size)
+                        .add("repetitions", t.seconds.size())
+                        .add("ns_per_element_min", t.min() * 1e9 / size)
+                        .add("ns_per_element_median", median * 1e9 / size)
+                        .add("relative_to_std_sort", median / reference)
+                        .add("stack_bytes", stack);
+                    if (alg.sorts)
+                        result.add("sorted", sorted);
+                    // counters per element
+                    if (pCounters)
+                        counters.add_to(result, "", double(t.seconds.size()) * size);
+                    report.add(result);
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    auto opts = bench::parse_options(argc, argv);
+    bench::report report("sort");
+    report.header()
+        .add("type", opts.type)
+        .add("seed", opts.seed)
+        .add("time_budget", opts.time_budget)
+        .add("perf", opts.perf);
+
+    if (opts.type == "int")
+        run<int>(opts, report);
+    else if (opts.type == "double")
+        run<double>(opts, report);
+    else {
+        std::cerr << "Unknown type: " << opts.type << std::endl;
+        return 1;
+    }
+
+    report.write(std::cout);
+    return 0;
+}
@@ -0,0 +1,315 @@
+#include "common.hpp"
+#include "keys.hpp"
+#include "histogram.hpp"
+#include "algs/tree/bst_recursive.hpp"
+#include "algs/tree/avl.hpp"
+#include "algs/tree/rb.hpp"
+
+#include <map>
+
+namespace {
+    using Key = int;
+    using Value = int;
+
+    const size_t UNLIMITED = std::numeric_limits<size_t>::max();
+
+    /**
+     * Uniform interface over benchmarked containers. Operations return
+     * values folded into a checksum, so lookups are not optimized away
+     **/
+    template<typename Tree, bool CanRemove>
+    class algs_tree {
+    public:
+        static constexpr bool can_remove = CanRemove;
+        static constexpr bool has_height = true;
+
+        void insert(Key key, Value value) { mTree.insert(key, value); }
+        Value find(Key key) { return mTree.find(key).second; }
+        bool contains(Key key) { return mTree.contains(key); }
+        Key select(size_t k) { return mTree.select(k).first; }
+        void remove(Key key) {
+            if constexpr(CanRemove)
+                mTree.remove(key);
+        }
+        size_t size() { return mTree.size(); }
+        size_t height() { return mTree.height(); }
+        algs::tree::shape_profile profile() { return mTree.profile(); }
+        algs::tree::memory_stats memory_usage() { return mTree.memory_usage(); }
+
+    private:
+        Tree mTree;
+    };
+
+    class std_map {
+    public:
+        static constexpr bool can_remove = true;
+        static constexpr bool has_height = false;
+
+        void insert(Key key, Value value) { mMap[key] = value; }
+        Value find(Key key) {
+            auto it = mMap.find(key);
+            return it == mMap.end() ? Value() : it->second;
+        }
+        bool contains(Key key) { return mMap.count(key) != 0; }
+        // NOTE: std::map has no order statistics, this is O(k)
+        Key select(size_t k) { return std::next(mMap.begin(), k)->first; }
+        void remove(Key key) { mMap.erase(key); }
+        size_t size() { return mMap.size(); }
+        size_t height() { return 0; }
+
+    private:
+        std::map<Key, Value> mMap;
+    };
+
+    class sorted_vector {
+    public:
+        static constexpr bool can_remove = true;
+        static constexpr bool has_height = false;
+
+        void insert(Key key, Value value) {
+            auto it = lower_bound(key);
+            if (it != mData.end() && it->first == key)
+                it->second = value;
+            else
+                mData.insert(it, std::make_pair(key, value));
+        }
+        Value find(Key key) {
+            auto it = lower_bound(key);
+            return it != mData.end() && it->first == key ? it->second : Value();
+        }
+        bool contains(Key key) {
+            auto it = lower_bound(key);
+            return it != mData.end() && it->first == key;
+        }
+        Key select(size_t k) { return mData[k].first; }
+        void remove(Key key) {
+            auto it = lower_bound(key);
+            if (it != mData.end() && it->first == key)
+                mData.erase(it);
+        }
+        size_t size() { return mData.size(); }
+        size_t height() { return 0; }
+
+    private:
+        using value_type = std::pair<Key, Value>;
+
+        std::vector<value_type>::iterator lower_bound(Key key) {
+            return std::lower_bound(mData.begin(), mData.end(), key,
+                [](const value_type& lhs, Key rhs) { return lhs.first < rhs; });
+        }
+
+        std::vector<value_type> mData;
+    };
+
+    /**
+     * Key stream used to fill a container and its lookup keys
+     **/
+    struct Stream {
+        const char *name;
+        std::vector<Key> (*keys)(size_t, std::mt19937&);
+    };
+
+    std::vector<Stream> streams() {
+        return {
+            { "sequential", [](size_t n, std::mt19937&) { return bench::sequential_keys<Key>(n); } },
+            { "random", bench::random_keys<Key> },
+            { "zipfian", [](size_t n, std::mt19937& gen) { return bench::zipfian_keys<Key>(n, gen); } },
+            { "clustered", [](size_t n, std::mt19937& gen) { return bench::clustered_keys<Key>(n, gen); } },
+        };
+    }
+
+    /**
+     * Measurements collected in addition to throughput
+     **/
+    struct Probes {
+        bench::perf_counters *counters; // nullptr if disabled
+        bool latency;
+        bench::record extra; // per-phase counters and latencies
+    };
+
+    /**
+     * Time a phase of `ops` calls of `op(i)`. Adds hardware counters per
+     * operation and latency percentiles in ns to `probes.extra` as
+     * `<phase>_<counter>` and `<phase>_latency_<percentile>` if enabled.
+     * NOTE: With latencies, throughput includes two timer reads per operation
+     **/
+    template<typename Op>
+    double ns_per_op(const std::string& phase, size_t ops, Op op, Probes& probes) {
+        bench::latency_histogram<> histogram;
+        if (probes.counters) {
+            probes.counters->reset();
+            probes.counters->start();
+        }
+        auto start = bench::clock::now();
+        if (probes.latency)
+            for (size_t i = 0; i < ops; ++i)
+                histogram.time([&] { op(i); });
+        else
+            for (size_t i = 0; i < ops; ++i)
+                op(i);
+        double elapsed = bench::seconds_since(start);
+        if (probes.counters) {
+            probes.counters->stop();
+            probes.counters->add_to(probes.extra, phase + "_", double(std::max<size_t>(ops, 1)));
+        }
+        if (probes.latency) {
+            double scale = bench::latency_timer::ns_per_tick();
+            histogram.add_to(probes.extra, phase + "_latency_", scale);
+            std::cerr << "  " << phase << " latency, ns:" << std::endl;
+            histogram.print(std::cerr, scale);
+        }
+        return elapsed * 1e9 / std::max<size_t>(ops, 1);
+    }
+
+    /**
+     * Add expected search costs and the depth histogram of a tree
+     **/
+    void add_profile(bench::record& record, const algs::tree::shape_profile& profile) {
+        std::ostringstream depths;
+        for (size_t depth = 0; depth < profile.depth_histogram.size(); ++depth)
+            depths << (depth ? ", " : "") << profile.depth_histogram[depth];
+        record.add("internal_path_length", profile.internal_path_length)
+            .add("avg_successful_comparisons", profile.avg_successful_comparisons())
+            .add("avg_unsuccessful_comparisons", profile.avg_unsuccessful_comparisons())
+            .add_json("depth_histogram", "[" + depths.str() + "]");
+    }
+
+    /**
+     * Insert all stream keys, then look them up, select ranks and remove
+     * distinct keys in random order. `max_sequential` and `max_other`
+     * cap sizes for containers degrading to quadratic time
+     **/
+    template<typename Container>
+    void run(const char *name, size_t max_sequential, size_t max_other,
+             const bench::options& opts, bench::report& report) {
+        if (!bench::selected(opts.algorithms, name))
+            return;
+        bench::perf_counters counters;
+        bench::perf_counters *pCounters = opts.perf ? &counters : nullptr;
+        if (opts.perf && !counters.available())
+            std::cerr << "Performance counters are not available" << std::endl;
+
+        for (auto size : bench::decimal_sizes(opts.min_size, opts.max_size)) {
+            for (const auto& stream : streams()) {
+                if (!bench::selected(opts.distributions, stream.name, true))
+                    continue;
+                bool sequential = std::strcmp(stream.name, "sequential") == 0;
+                if (size > (sequential ? max_sequential : max_other))
+                    continue;
+
+                std::mt19937 gen(opts.seed);
+                auto keys = stream.keys(size, gen);
+                // lookups follow the stream's distribution, but in a different order
+                auto lookups = stream.keys(size, gen);
+                std::shuffle(lookups.begin(), lookups.end(), gen);
+                // distinct keys in random order for removal
+                auto distinct = keys;
+                std::sort(distinct.begin(), distinct.end());
+                distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+                std::shuffle(distinct.begin(), distinct.end(), gen);
+                // ranks for select, limited to ~1e7 visited nodes for O(n) selects
+                std::vector<size_t> ranks(std::max<size_t>(1, 10000000 / size));
+                std::uniform_int_distribution<size_t> rank_dis(0, distinct.size() - 1);
+                for (auto& rank : ranks)
+                    rank = rank_dis(gen);
+
+                long checksum = 0;
+                Probes probes{ pCounters, opts.latency, bench::record() };
+                size_t heap_before = bench::heap_in_use();
+                auto *pContainer = new Container();
+                auto& container = *pContainer;
+
+                std::cerr << name << ' ' << stream.name << ' ' << size << std::endl;
+                double insert_ns = ns_per_op("insert", keys.size(), [&](size_t i) {
+                    container.insert(keys[i], keys[i]);
+                }, probes);
+                size_t heap_after = bench::heap_in_use();
+                size_t count = container.size();
+                bench::record memory; // node accounting of the tree itself
+                if constexpr(Container::has_height) {
+                    auto stats = container.memory_usage();
+                    memory.add("node_bytes", stats.node_bytes)
+                        .add("node_bytes_per_key", stats.bytes_per_node())
+                        .add("slack_bytes_per_key", double(stats.slack_bytes()) / std::max<size_t>(count, 1));
+                }
+
+                double find_ns = ns_per_op("find", lookups.size(), [&](size_t i) {
+                    checksum += container.find(lookups[i]);
+                }, probes);
+                // half of the lookups miss: keys are in [0, size)
+                double contains_ns = ns_per_op("contains", lookups.size(), [&](size_t i) {
+                    checksum += container.contains(i % 2 ? lookups[i] : lookups[i] + Key(size));
+                }, probes);
+                double select_ns = ns_per_op("select", ranks.size(), [&](size_t i) {
+                    checksum += container.select(ranks[i]);
+                }, probes);
+                size_t height = Container::has_height ? container.height() : 0;
+                bench::record shape;
+                if constexpr(Container::has_height)
+                    add_profile(shape, container.profile());
+                double remove_ns = std::numeric_limits<double>::quiet_NaN();
+                if constexpr(Container::can_remove)
+                    remove_ns = ns_per_op("remove", distinct.size(), [&](size_t i) {
+                        container.remove(distinct[i]);
+                    }, probes);
+                bench::do_not_optimize(checksum);
+                delete pContainer;
+
+                double bytes_per_key = heap_after > heap_before ?
+                    double(heap_after - heap_before) / count :
+                    std::numeric_limits<double>::quiet_NaN();
+
+                std::cerr << "  insert " << insert_ns << " ns, find " << find_ns
+                    << " ns, " << bytes_per_key << " bytes/key" << std::endl;
+
+                bench::record result;
+                result.add("structure", name)
+                    .add("distribution", stream.name)
+                    .add("size", size)
+                    .add("keys", count)
+                    .add("insert_ns", insert_ns)
+                    .add("find_ns", find_ns)
+                    .add("contains_ns", contains_ns)
+                    .add("select_ns", select_ns)
+                    .add("remove_ns", remove_ns)
+                    .add("bytes_per_key", bytes_per_key);
+                if (Container::has_height)
+                    result.add("height", height);
+                result.append(memory);
+                result.append(shape);
+                result.append(probes.extra);
+                report.add(result);
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    bench::options defaults;
+    defaults.min_size = 10000;
+    defaults.max_size = 10000000;
+    auto opts = bench::parse_options(argc, argv, defaults);
+    bench::report report("tree");
+    report.header()
+        .add("key", "int")
+        .add("value", "int")
+        .add("seed", opts.seed)
+        .add("perf", opts.perf)
+        .add("latency", opts.latency);
+
+    // NOTE: unbalanced bst on sequential keys is a linked list
+    //       with recursion as deep as its size
+    run<algs_tree<algs::tree::bst::bst_recursive_debug<Key, Value>, true>>(
+        "bst_recursive", 10000, UNLIMITED, opts, report);
+    // NOTE: avl and rb have no removal yet
+    run<algs_tree<algs::tree::avl::avl_debug<Key, Value>, false>>(
+        "avl", UNLIMITED, UNLIMITED, opts, report);
+    run<algs_tree<algs::tree::rb::rb_debug<Key, Value>, false>>(
+        "rb", UNLIMITED, UNLIMITED, opts, report);
+    run<std_map>("std::map", UNLIMITED, UNLIMITED, opts, report);
+    // NOTE: sorted vector inserts and removes in O(n)
+    run<sorted_vector>("sorted_vector", UNLIMITED, 100000, opts, report);
+
+    report.write(std::cout);
+    return 0;
+}
@@ -0,0 +1,353 @@
+#include "common.hpp"
+#include "keys.hpp"
+#include "histogram.hpp"
+#include "algs/tree/bst_recursive.hpp"
+#include "algs/tree/avl.hpp"
+#include "algs/tree/rb.hpp"
+
+#include <array>
+#include <map>
+
+namespace {
+    using Key = int;
+    using Value = int;
+
+    /**
+     * YCSB-style operations
+     **/
+    enum Operation { READ, UPDATE, INSERT, SCAN, DELETE, READ_MODIFY_WRITE, OPERATIONS };
+
+    const char *OPERATION_NAMES[OPERATIONS] = {
+        "read", "update", "insert", "scan", "delete", "read_modify_write"
+    };
+
+    /**
+     * Operation mix: weights of operations, need not sum to 1
+     **/
+    using Mix = std::array<double, OPERATIONS>;
+
+    struct Workload {
+        const char *name;
+        Mix mix;
+    };
+
+    // YCSB core workloads A-F and a churn workload replacing keys
+    std::vector<Workload> workloads() {
+        return {
+            { "A", { .5, .5, 0, 0, 0, 0 } }, // update heavy
+            { "B", { .95, .05, 0, 0, 0, 0 } }, // read mostly
+            { "C", { 1, 0, 0, 0, 0, 0 } }, // read only
+            { "D", { .95, 0, .05, 0, 0, 0 } }, // read latest
+            { "E", { 0, 0, .05, .95, 0, 0 } }, // short ranges
+            { "F", { .5, 0, 0, 0, 0, .5 } }, // read-modify-write
+            { "churn", { .5, 0, .25, 0, .25, 0 } }, // inserts and deletes
+        };
+    }
+
+    /**
+     * Parse a mix like "read=0.5,update=0.3,delete=0.2"
+     **/
+    Mix parse_mix(const std::string& value) {
+        Mix mix{};
+        std::istringstream in(value);
+        for (std::string item; std::getline(in, item, ',');) {
+            auto eq = item.find('=');
+            auto name = item.substr(0, eq);
+            size_t op = 0;
+            while (op < OPERATIONS && name != OPERATION_NAMES[op])
+                ++op;
+            if (eq == std::string::npos || op == OPERATIONS)
+                throw std::invalid_argument("bad operation mix: " + value);
+            mix[op] = std::stod(item.substr(eq + 1));
+        }
+        return mix;
+    }
+
+    /**
+     * Uniform interface over benchmarked containers
+     **/
+    template<typename Tree, bool Splay, bool CanRemove>
+    class algs_tree : public Tree {
+    public:
+        using node_type = typename Tree::node_type;
+
+        static constexpr bool can_remove = CanRemove;
+        static constexpr bool has_height = true;
+
+        void put(Key key, Value value) {
+            if constexpr(Splay)
+                this->insert_splay(key, value);
+            else
+                this->insert(key, value);
+        }
+
+        Value get(Key key) {
+            return this->find(key).second;
+        }
+
+        void erase(Key key) {
+            if constexpr(CanRemove)
+                this->remove(key);
+        }
+
+        /**
+         * Sum values of `count` keys starting from the least key >= `from`
+         **/
+        long scan(Key from, size_t count) {
+            node_type *pNode = nullptr;
+            for (node_type *pCurr = this->root(); pCurr != nullptr;) {
+                if (pCurr->mData.first < from)
+                    pCurr = pCurr->mpRight;
+                else {
+                    pNode = pCurr;
+                    pCurr = pCurr->mpLeft;
+                }
+            }
+            long sum = 0;
+            for (size_t i = 0; pNode != nullptr && i < count; ++i, pNode = pNode->next())
+                sum += pNode->mData.second;
+            return sum;
+        }
+    };
+
+    class std_map {
+    public:
+        static constexpr bool can_remove = true;
+        static constexpr bool has_height = false;
+
+        void put(Key key, Value value) { mMap[key] = value; }
+        Value get(Key key) {
+            auto it = mMap.find(key);
+            return it == mMap.end() ? Value() : it->second;
+        }
+        void erase(Key key) { mMap.erase(key); }
+        long scan(Key from, size_t count) {
+            long sum = 0;
+            auto it = mMap.lower_bound(from);
+            for (size_t i = 0; it != mMap.end() && i < count; ++i, ++it)
+                sum += it->second;
+            return sum;
+        }
+        size_t size() { return mMap.size(); }
+        size_t height() { return 0; }
+
+    private:
+        std::map<Key, Value> mMap;
+    };
+
+    /**
+     * Picks records by their insertion sequence numbers. Keys are
+     * hashed sequence numbers, so inserts are not ordered
+     **/
+    class KeyChooser {
+    public:
+        KeyChooser(const std::string& distribution, size_t records)
+            : mDistribution(distribution), mZipfian(records)
+        {}
+
+        static Key key(uint64_t sequence) {
+            return Key(bench::scramble(sequence, std::numeric_limits<Key>::max()));
+        }
+
+        // sequence number of an existing (or deleted) record
+        uint64_t choose(uint64_t inserted, std::mt19937& gen) {
+            if (mDistribution == "uniform")
+                return std::uniform_int_distribution<uint64_t>(0, inserted - 1)(gen);
+            uint64_t rank = mZipfian(gen) % inserted;
+            if (mDistribution == "latest") // popular are most recent ones
+                return inserted - 1 - rank;
+            return rank;
+        }
+
+    private:
+        std::string mDistribution;
+        bench::zipfian mZipfian;
+    };
+
+    struct Settings {
+        size_t records;
+        size_t operations;
+        size_t window;
+        size_t scan_length;
+    };
+
+    /**
+     * Load `records` keys, then run `operations` operations of a mix,
+     * reporting throughput and tree height every `window` operations
+     **/
+    template<typename Container>
+    void run(const char *name, const Workload& workload, const std::string& distribution,
+             const Settings& settings, const bench::options& opts, bench::report& report) {
+        if (!Container::can_remove && workload.mix[DELETE] > 0) {
+            std::cerr << name << ' ' << workload.name << ' ' << distribution
+                << ": skipped, no removal" << std::endl;
+            return;
+        }
+        std::cerr << name << ' ' << workload.name << ' ' << distribution << std::endl;
+
+        std::mt19937 gen(opts.seed);
+        KeyChooser chooser(distribution, settings.records);
+        auto *pContainer = new Container();
+        auto& container = *pContainer;
+
+        uint64_t inserted = 0;
+        auto load_start = bench::clock::now();
+        for (; inserted < settings.records; ++inserted)
+            container.put(KeyChooser::key(inserted), Value(inserted));
+        double load_seconds = bench::seconds_since(load_start);
+
+        std::vector<double> cumulative;
+        double total_weight = 0;
+        for (double weight : workload.mix)
+            cumulative.push_back(total_weight += weight);
+        std::uniform_real_distribution<double> op_dis(0., total_weight);
+
+        std::array<size_t, OPERATIONS> counts{};
+        std::vector<bench::latency_histogram<>> histograms(OPERATIONS);
+        bench::perf_counters counters;
+        std::ostringstream windows;
+        long checksum = 0;
+        double run_seconds = 0;
+        double min_window = std::numeric_limits<double>::infinity(), max_window = 0;
+
+        if (opts.perf)
+            counters.reset();
+        for (size_t done = 0; done < settings.operations;) {
+            size_t window = std::min(settings.window, settings.operations - done);
+            // operations and keys are drawn before timing
+            std::vector<std::pair<Operation, Key>> ops(window);
+            for (auto& op : ops) {
+                double x = op_dis(gen);
+                op.first = Operation(std::upper_bound(cumulative.begin(), cumulative.end(), x) - cumulative.begin());
+                op.first = std::min(op.first, Operation(OPERATIONS - 1));
+                op.second = KeyChooser::key(op.first == INSERT ? inserted++ : chooser.choose(inserted, gen));
+            }
+
+            auto apply = [&](const std::pair<Operation, Key>& op) {
+                switch (op.first) {
+                case READ: checksum += container.get(op.second); break;
+                case UPDATE: container.put(op.second, Value(checksum)); break;
+                case INSERT: container.put(op.second, op.second); break;
+                case SCAN: checksum += container.scan(op.second, settings.scan_length); break;
+                case DELETE: container.erase(op.second); break;
+                case READ_MODIFY_WRITE: container.put(op.second, container.get(op.second) + 1); break;
+                default: break;
+                }
+            };
+
+            if (opts.perf)
+                counters.start();
+            auto start = bench::clock::now();
+            if (opts.latency)
+                for (const auto& op : ops)
+                    histograms[op.first].time([&] { apply(op); });
+            else
+                for (const auto& op : ops)
+                    apply(op);
+            double seconds = bench::seconds_since(start);
+            if (opts.perf)
+                counters.stop();
+
+            for (const auto& op : ops)
+                ++counts[op.first];
+            done += window;
+            run_seconds += seconds;
+            double mops = window / seconds / 1e6;
+            min_window = std::min(min_window, mops);
+            max_window = std::max(max_window, mops);
+            size_t height = Container::has_height ? container.height() : 0;
+            windows << (windows.tellp() ? ", " : "") << "{\"operations\": " << done
+                << ", \"mops\": " << mops;
+            if (Container::has_height)
+                windows << ", \"height\": " << height;
+            windows << '}';
+            std::cerr << "  " << done << " ops: " << mops << " Mops/s";
+            if (Container::has_height)
+                std::cerr << ", height " << height;
+            std::cerr << std::endl;
+        }
+        bench::do_not_optimize(checksum);
+
+        bench::record result;
+        result.add("structure", name)
+            .add("workload", workload.name)
+            .add("distribution", distribution)
+            .add("records", settings.records)
+            .add("operations", settings.operations)
+            .add("load_mops", settings.records / load_seconds / 1e6)
+            .add("mops", settings.operations / run_seconds / 1e6)
+            .add("min_window_mops", min_window)
+            .add("max_window_mops", max_window)
+            .add("final_size", container.size());
+        if (Container::has_height)
+            result.add("final_height", container.height());
+        for (size_t op = 0; op < OPERATIONS; ++op)
+            result.add(std::string(OPERATION_NAMES[op]) + "_count", counts[op]);
+        if (opts.perf)
+            counters.add_to(result, "", double(settings.operations));
+        if (opts.latency)
+            for (size_t op = 0; op < OPERATIONS; ++op)
+                if (counts[op])
+                    histograms[op].add_to(result, std::string(OPERATION_NAMES[op]) + "_latency_",
+                        bench::latency_timer::ns_per_tick());
+        result.add_json("windows", "[" + windows.str() + "]");
+        report.add(result);
+
+        delete pContainer;
+    }
+
+    template<typename Container>
+    void run_all(const char *name, const std::vector<Workload>& selected, const Settings& settings,
+                 const bench::options& opts, bench::report& report) {
+        if (!bench::selected(opts.algorithms, name))
+            return;
+        for (const auto& workload : selected)
+            for (const char *distribution : { "uniform", "zipfian", "latest" })
+                if (bench::selected(opts.distributions, distribution, true))
+                    run<Container>(name, workload, distribution, settings, opts, report);
+    }
+}
+
+int main(int argc, char **argv) {
+    Settings settings;
+    settings.records = size_t(std::stod(bench::take_option(argc, argv, "--records", "1e5")));
+    settings.operations = size_t(std::stod(bench::take_option(argc, argv, "--operations", "1e6")));
+    settings.window = size_t(std::stod(bench::take_option(argc, argv, "--window", "1e5")));
+    settings.scan_length = size_t(std::stod(bench::take_option(argc, argv, "--scan-length", "100")));
+    auto workload_names = bench::take_option(argc, argv, "--workloads", "");
+    auto mix = bench::take_option(argc, argv, "--mix", "");
+    auto opts = bench::parse_options(argc, argv);
+
+    std::vector<Workload> selected;
+    if (!mix.empty())
+        selected.push_back({ "custom", parse_mix(mix) });
+    else
+        for (const auto& workload : workloads())
+            if (bench::selected(workload_names, workload.name, true))
+                selected.push_back(workload);
+
+    bench::report report("workload");
+    report.header()
+        .add("records", settings.records)
+        .add("operations", settings.operations)
+        .add("window", settings.window)
+        .add("scan_length", settings.scan_length)
+        .add("seed", opts.seed)
+        .add("perf", opts.perf)
+        .add("latency", opts.latency);
+
+    using namespace algs::tree;
+    run_all<algs_tree<bst::bst_recursive<Key, Value>, false, true>>(
+        "bst_recursive", selected, settings, opts, report);
+    run_all<algs_tree<bst::bst_recursive<Key, Value>, true, true>>(
+        "bst_recursive::insert_splay", selected, settings, opts, report);
+    // NOTE: avl and rb have no removal yet
+    run_all<algs_tree<avl::avl<Key, Value>, false, false>>(
+        "avl", selected, settings, opts, report);
+    run_all<algs_tree<rb::rb_debug<Key, Value>, false, false>>(
+        "rb", selected, settings, opts, report);
+    run_all<std_map>("std::map", selected, settings, opts, report);
+
+    report.write(std::cout);
+    return 0;
+}
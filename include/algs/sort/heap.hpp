@@ -1,4 +1,11 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
 #include <iterator>
+#include <vector>
+
+#include "observer.hpp"
 
 namespace algs::sort::heap {
     /**
@@ -51,20 +58,24 @@ namespace algs::sort::heap {
     }
 
     /**
-     * Sift down `current` element in `begin`-`end` max heap
+     * Sift down `current` element in `begin`-`end` max heap,
+     * reporting levels it moved to an `observer`
      **/
     template<
-        typename RandomAccessIterator
+        typename RandomAccessIterator,
+        typename Observer
     >
     void
     sift_down(
         RandomAccessIterator begin,
         RandomAccessIterator current,
-        RandomAccessIterator end
+        RandomAccessIterator end,
+        Observer& observer
     ) {
         assert(begin <= current);
         assert(current <= end);
 
+        size_t levels = 0;
         while (current < end) {
             auto swap = current;
             auto child = std::next(begin, std::distance(begin, current) * 2 + 1);
@@ -77,46 +88,250 @@ namespace algs::sort::heap {
                 break;
             std::iter_swap(swap, current);
             current = swap;
+            ++levels;
         }
+        observer.sift(levels);
     }
 
     /**
-     * Make heap from collection
+     * Sift down `current` element in `begin`-`end` max heap
      **/
     template<
         typename RandomAccessIterator
     >
     void
-    make_heap(
+    sift_down(
         RandomAccessIterator begin,
+        RandomAccessIterator current,
         RandomAccessIterator end
+    ) {
+        null_observer observer;
+        algs::sort::heap::sift_down(begin, current, end, observer);
+    }
+
+    /**
+     * Make heap from collection
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    make_heap(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Observer& observer
     ) {
         auto current = std::next(begin, std::distance(begin, end) / 2 - 1);
         while (std::distance(begin, current) >= 0) {
-            sift_down(begin, current, end);
+            sift_down(begin, current, end, observer);
             --current;
         }
     }
 
     /**
-     * Heap sort
+     * Make heap from collection
      **/
     template<
         typename RandomAccessIterator
     >
     void
-    sort(
+    make_heap(
         RandomAccessIterator begin,
         RandomAccessIterator end
     ) {
-        algs::sort::heap::make_heap(begin, end);
+        null_observer observer;
+        algs::sort::heap::make_heap(begin, end, observer);
+    }
+
+    /**
+     * Sort a max heap by moving its maximum to the end one by one,
+     * reporting sift distances to an `observer`
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    sort_heap(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Observer& observer
+    ) {
+        while (std::distance(begin, end) > 1) {
+            --end;
+            std::iter_swap(begin, end);
+            sift_down(begin, begin, end, observer);
+        }
+    }
+
+    /**
+     * Sort a max heap by moving its maximum to the end one by one
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    sort_heap(
+        RandomAccessIterator begin,
+        RandomAccessIterator end
+    ) {
+        null_observer observer;
+        algs::sort::heap::sort_heap(begin, end, observer);
+    }
+
+    /**
+     * Heap sort, reporting sift distances to an `observer`
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    sort(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Observer& observer
+    ) {
+        algs::sort::heap::make_heap(begin, end, observer);
         auto last = std::prev(end);
         while (std::distance(begin, last) >= 0) {
             std::iter_swap(begin, last);
             end = last;
             --last;
-            sift_down(begin, begin, end);
+            sift_down(begin, begin, end, observer);
         }
     }
-} // namespace algs::sort::heap
 
+    /**
+     * Heap sort
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    sort(
+        RandomAccessIterator begin,
+        RandomAccessIterator end
+    ) {
+        null_observer observer;
+        algs::sort::heap::sort(begin, end, observer);
+    }
+
+    /**
+     * Partial sort: put `middle - begin` minimal elements of a collection
+     * into [begin, middle) in sorted order, reporting sift distances to an
+     * `observer`. [begin, middle) is kept as a max heap of the minimal
+     * elements seen so far, a smaller element replaces its maximum.
+     * O(n log k) time, no extra memory, where k = middle - begin
+     * NOTE: Order of [middle, end) is unspecified
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    partial_sort(
+        RandomAccessIterator begin,
+        RandomAccessIterator middle,
+        RandomAccessIterator end,
+        Observer& observer
+    ) {
+        assert(begin <= middle);
+        assert(middle <= end);
+
+        if (begin == middle)
+            return;
+        algs::sort::heap::make_heap(begin, middle, observer);
+        for (auto it = middle; it != end; ++it) {
+            if (*it < *begin) {
+                std::iter_swap(it, begin);
+                sift_down(begin, begin, middle, observer);
+            }
+        }
+        algs::sort::heap::sort_heap(begin, middle, observer);
+    }
+
+    /**
+     * Partial sort: put `middle - begin` minimal elements of a collection
+     * into [begin, middle) in sorted order
+     * NOTE: Order of [middle, end) is unspecified
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    partial_sort(
+        RandomAccessIterator begin,
+        RandomAccessIterator middle,
+        RandomAccessIterator end
+    ) {
+        null_observer observer;
+        algs::sort::heap::partial_sort(begin, middle, end, observer);
+    }
+
+    /**
+     * Copy min(n, result_end - result_begin) minimal elements of a single
+     * pass input sequence into [result_begin, result_end) in sorted order.
+     * The output range is used as the bounded max heap of partial_sort.
+     * O(n log k) time, no extra memory
+     * NOTE: Returns the end of the copied elements
+     **/
+    template<
+        typename InputIterator,
+        typename RandomAccessIterator
+    >
+    RandomAccessIterator
+    partial_sort_copy(
+        InputIterator first,
+        InputIterator last,
+        RandomAccessIterator result_begin,
+        RandomAccessIterator result_end
+    ) {
+        auto result_last = result_begin;
+        for (; first != last && result_last != result_end; ++first, ++result_last)
+            *result_last = *first;
+        if (result_begin == result_last)
+            return result_last;
+        algs::sort::heap::make_heap(result_begin, result_last);
+        for (; first != last; ++first) {
+            if (*first < *result_begin) {
+                *result_begin = *first;
+                sift_down(result_begin, result_begin, result_last);
+            }
+        }
+        algs::sort::heap::sort_heap(result_begin, result_last);
+        return result_last;
+    }
+
+    /**
+     * Return min(n, k) minimal elements of a single pass input sequence,
+     * e.g. a stream, in sorted order. Keeps a max heap of k elements.
+     * O(n log k) time, O(k) memory
+     **/
+    template<
+        typename InputIterator,
+        typename T = typename std::iterator_traits<InputIterator>::value_type
+    >
+    std::vector<T>
+    top_k(
+        InputIterator first,
+        InputIterator last,
+        size_t k
+    ) {
+        std::vector<T> result;
+        for (; first != last && result.size() < k; ++first)
+            result.push_back(*first);
+        if (result.empty())
+            return result;
+        algs::sort::heap::make_heap(result.begin(), result.end());
+        for (; first != last; ++first) {
+            if (*first < result.front()) {
+                result.front() = *first;
+                sift_down(result.begin(), result.begin(), result.end());
+            }
+        }
+        algs::sort::heap::sort_heap(result.begin(), result.end());
+        return result;
+    }
+} // namespace algs::sort::heap
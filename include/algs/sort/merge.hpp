@@ -1,3 +1,16 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "observer.hpp"
+#include "scratch.hpp"
+
 namespace algs::sort::merge {
     /**
      * Merges two collections into a sorted output one.
@@ -173,21 +186,81 @@ namespace algs::sort::merge {
      **/
     template<
         typename ForwardIterator,
-        typename ForwardIteratorTmp
+        typename ForwardIteratorTmp,
+        typename Observer
     >
     void
     sort_recursive_impl(
         ForwardIterator begin,
         ForwardIterator end,
-        ForwardIteratorTmp tmp
+        ForwardIteratorTmp tmp,
+        Observer& observer
     ) {
         auto size = std::distance(begin, end);
         if (size < 2)
             return;
+        observer.enter();
         auto mid = std::next(begin, size / 2);
-        sort_recursive_impl(begin, mid, tmp);
-        sort_recursive_impl(mid, end, tmp);
+        sort_recursive_impl(begin, mid, tmp, observer);
+        sort_recursive_impl(mid, end, tmp, observer);
+        observer.merge(size / 2, size - size / 2);
         merge_tmp(begin, mid, end, tmp);
+        observer.leave();
+    }
+
+    /**
+     * Recursive merge sort with a caller-owned `scratch` buffer, reporting
+     * recursion and merged runs to an `observer`
+     * NOTE: Uses std::distance(begin, end) elements of the scratch buffer
+     **/
+    template<
+        typename ForwardIterator,
+        typename Observer
+    >
+    void
+    sort_recursive(
+        ForwardIterator begin,
+        ForwardIterator end,
+        scratch_buffer<typename std::iterator_traits<ForwardIterator>::value_type>& scratch,
+        Observer& observer
+    ) {
+        auto size = std::distance(begin, end);
+        sort_recursive_impl(begin, end, scratch.get(size), observer);
+    }
+
+    /**
+     * Recursive merge sort, reporting recursion and merged runs to an `observer`
+     * NOTE: Uses temporary array of size std::distance(begin, end)
+     **/
+    template<
+        typename ForwardIterator,
+        typename Observer
+    >
+    void
+    sort_recursive(
+        ForwardIterator begin,
+        ForwardIterator end,
+        Observer& observer
+    ) {
+        scratch_buffer<typename std::iterator_traits<ForwardIterator>::value_type> scratch;
+        algs::sort::merge::sort_recursive(begin, end, scratch, observer);
+    }
+
+    /**
+     * Recursive merge sort with a caller-owned `scratch` buffer
+     * NOTE: Uses std::distance(begin, end) elements of the scratch buffer
+     **/
+    template<
+        typename ForwardIterator
+    >
+    void
+    sort_recursive(
+        ForwardIterator begin,
+        ForwardIterator end,
+        scratch_buffer<typename std::iterator_traits<ForwardIterator>::value_type>& scratch
+    ) {
+        null_observer observer;
+        algs::sort::merge::sort_recursive(begin, end, scratch, observer);
     }
 
     /**
@@ -202,32 +275,115 @@ namespace algs::sort::merge {
         ForwardIterator begin,
         ForwardIterator end
     ) {
-        using value_type = typename std::iterator_traits<ForwardIterator>::value_type;
-        auto size = std::distance(begin, end);
-        std::vector<value_type> tmp(size);
-        sort_recursive_impl(begin, end, tmp.begin());
+        null_observer observer;
+        algs::sort::merge::sort_recursive(begin, end, observer);
     }
 
     /**
-     * In-place recursive merge sort
+     * In-place recursive merge sort, reporting
+     * recursion and merged runs to an `observer`
      **/
     template<
-        typename ForwardIterator
+        typename ForwardIterator,
+        typename Observer
     >
     void
     sort_recursive_inplace(
         ForwardIterator begin,
-        ForwardIterator end
+        ForwardIterator end,
+        Observer& observer
     ) {
         auto size = std::distance(begin, end);
         if (size < 2)
             return;
         auto mid = std::next(begin, size / 2);
-        sort_recursive(begin, mid);
-        sort_recursive(mid, end);
+        sort_recursive(begin, mid, observer);
+        sort_recursive(mid, end, observer);
+        observer.merge(size / 2, size - size / 2);
         algs::sort::merge::inplace_merge(begin, mid, end);
     }
 
+    /**
+     * In-place recursive merge sort
+     **/
+    template<
+        typename ForwardIterator
+    >
+    void
+    sort_recursive_inplace(
+        ForwardIterator begin,
+        ForwardIterator end
+    ) {
+        null_observer observer;
+        algs::sort::merge::sort_recursive_inplace(begin, end, observer);
+    }
+
+    /**
+     * Bottom-up merge sort with a caller-owned `scratch` buffer, reporting
+     * merged runs to an `observer`
+     * NOTE: Uses std::distance(begin, end) elements of the scratch buffer
+     * NOTE: Internal checks require RandomAccessIterator!
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    sort_bottomup(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        scratch_buffer<typename std::iterator_traits<RandomAccessIterator>::value_type>& scratch,
+        Observer& observer
+    ) {
+        size_t max_size = std::distance(begin, end);
+        auto tmp_begin = scratch.get(max_size);
+        for (size_t size = 1; size < max_size; size *= 2) {
+            auto it_stop = std::prev(end, size);
+            for (auto it = begin; it < it_stop; std::advance(it, size+size)) {
+                auto it_end = std::min(std::next(it, size+size), end);
+                observer.merge(size, std::distance(it, it_end) - size);
+                algs::sort::merge::merge_tmp(it, std::next(it, size), it_end, tmp_begin);
+            }
+        }
+    }
+
+    /**
+     * Bottom-up merge sort, reporting merged runs to an `observer`
+     * NOTE: Uses temporary array of size std::distance(begin, end)
+     * NOTE: Internal checks require RandomAccessIterator!
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    sort_bottomup(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Observer& observer
+    ) {
+        scratch_buffer<typename std::iterator_traits<RandomAccessIterator>::value_type> scratch;
+        algs::sort::merge::sort_bottomup(begin, end, scratch, observer);
+    }
+
+    /**
+     * Bottom-up merge sort with a caller-owned `scratch` buffer
+     * NOTE: Uses std::distance(begin, end) elements of the scratch buffer
+     * NOTE: Internal checks require RandomAccessIterator!
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    sort_bottomup(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        scratch_buffer<typename std::iterator_traits<RandomAccessIterator>::value_type>& scratch
+    ) {
+        null_observer observer;
+        algs::sort::merge::sort_bottomup(begin, end, scratch, observer);
+    }
+
     /**
      * Bottom-up merge sort.
      * NOTE: Uses temporary array of size std::distance(begin, end)
@@ -241,14 +397,32 @@ namespace algs::sort::merge {
         RandomAccessIterator begin,
         RandomAccessIterator end
     ) {
-        using value_type = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        null_observer observer;
+        algs::sort::merge::sort_bottomup(begin, end, observer);
+    }
+
+    /**
+     * Bottom-up in-place merge sort, reporting merged runs to an `observer`
+     * NOTE: Internal checks require RandomAccessIterator!
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    sort_bottomup_inplace(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Observer& observer
+    ) {
         size_t max_size = std::distance(begin, end);
-        std::vector<value_type> tmp(max_size);
-        auto tmp_begin = tmp.begin();
         for (size_t size = 1; size < max_size; size *= 2) {
             auto it_stop = std::prev(end, size);
-            for (auto it = begin; it < it_stop; std::advance(it, size+size))
-                algs::sort::merge::merge_tmp(it, std::next(it, size), std::min(std::next(it, size+size), end), tmp_begin);
+            for (auto it = begin; it < it_stop; std::advance(it, size+size)) {
+                auto it_end = std::min(std::next(it, size+size), end);
+                observer.merge(size, std::distance(it, it_end) - size);
+                algs::sort::merge::inplace_merge(it, std::next(it, size), it_end);
+            }
         }
     }
 
@@ -264,12 +438,763 @@ namespace algs::sort::merge {
         RandomAccessIterator begin,
         RandomAccessIterator end
     ) {
-        size_t max_size = std::distance(begin, end);
-        for (size_t size = 1; size < max_size; size *= 2) {
-            auto it_stop = std::prev(end, size);
-            for (auto it = begin; it < it_stop; std::advance(it, size+size))
-                algs::sort::merge::inplace_merge(it, std::next(it, size), std::min(std::next(it, size+size), end));
+        null_observer observer;
+        algs::sort::merge::sort_bottomup_inplace(begin, end, observer);
+    }
+
+    /**
+     * Moves two sorted collections into a sorted output one
+     * NOTE: Stable, equal elements of the left collection go first
+     * NOTE: Requires input collections to be pre-sorted
+     **/
+    template<
+        typename InputIterator1,
+        typename InputIterator2,
+        typename OutputIterator
+    >
+    OutputIterator
+    merge_move(
+        InputIterator1 left_begin,
+        InputIterator1 left_end,
+        InputIterator2 right_begin,
+        InputIterator2 right_end,
+        OutputIterator out
+    ) {
+        while (left_begin != left_end && right_begin != right_end) {
+            if (*right_begin < *left_begin)
+                *out++ = std::move(*right_begin++);
+            else
+                *out++ = std::move(*left_begin++);
+        }
+        out = std::move(left_begin, left_end, out);
+        return std::move(right_begin, right_end, out);
+    }
+
+    /**
+     * Implementation of a recursive ping-pong merge sort. DO NOT USE DIRECTLY
+     * Sorts [begin, end) into `other` if `into_other`, in place otherwise:
+     * halves are sorted into the opposite collection and merged back,
+     * so each level moves elements once between the collections
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename RandomAccessIteratorOther,
+        typename Observer
+    >
+    void
+    sort_recursive_pingpong_impl(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        RandomAccessIteratorOther other,
+        bool into_other,
+        Observer& observer
+    ) {
+        auto size = std::distance(begin, end);
+        if (size < 2) {
+            if (into_other)
+                std::move(begin, end, other);
+            return;
+        }
+        observer.enter();
+        auto mid = std::next(begin, size / 2);
+        auto other_mid = std::next(other, size / 2), other_end = std::next(other, size);
+        sort_recursive_pingpong_impl(begin, mid, other, !into_other, observer);
+        sort_recursive_pingpong_impl(mid, end, other_mid, !into_other, observer);
+        observer.merge(size / 2, size - size / 2);
+        if (into_other)
+            algs::sort::merge::merge_move(begin, mid, mid, end, other);
+        else
+            algs::sort::merge::merge_move(other, other_mid, other_mid, other_end, begin);
+        observer.leave();
+    }
+
+    /**
+     * Recursive ping-pong merge sort with a caller-owned `scratch` buffer,
+     * reporting recursion and merged runs to an `observer`. Levels
+     * alternate between the collection and the buffer, so unlike
+     * sort_recursive every level moves each element once instead of
+     * copying it twice. Leaves of the recursion tree of a different level
+     * parity move to the buffer first
+     * NOTE: Stable
+     * NOTE: Uses std::distance(begin, end) elements of the scratch buffer
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    sort_recursive_pingpong(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        scratch_buffer<typename std::iterator_traits<RandomAccessIterator>::value_type>& scratch,
+        Observer& observer
+    ) {
+        auto tmp = scratch.get(std::distance(begin, end));
+        sort_recursive_pingpong_impl(begin, end, tmp, false, observer);
+    }
+
+    /**
+     * Recursive ping-pong merge sort, reporting recursion and merged runs
+     * to an `observer`
+     * NOTE: Stable
+     * NOTE: Uses temporary array of size std::distance(begin, end)
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    sort_recursive_pingpong(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Observer& observer
+    ) {
+        scratch_buffer<typename std::iterator_traits<RandomAccessIterator>::value_type> scratch;
+        algs::sort::merge::sort_recursive_pingpong(begin, end, scratch, observer);
+    }
+
+    /**
+     * Recursive ping-pong merge sort with a caller-owned `scratch` buffer
+     * NOTE: Stable
+     * NOTE: Uses std::distance(begin, end) elements of the scratch buffer
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    sort_recursive_pingpong(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        scratch_buffer<typename std::iterator_traits<RandomAccessIterator>::value_type>& scratch
+    ) {
+        null_observer observer;
+        algs::sort::merge::sort_recursive_pingpong(begin, end, scratch, observer);
+    }
+
+    /**
+     * Recursive ping-pong merge sort
+     * NOTE: Stable
+     * NOTE: Uses temporary array of size std::distance(begin, end)
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    sort_recursive_pingpong(
+        RandomAccessIterator begin,
+        RandomAccessIterator end
+    ) {
+        null_observer observer;
+        algs::sort::merge::sort_recursive_pingpong(begin, end, observer);
+    }
+
+    /**
+     * Move-merge pairs of sorted runs of `width` elements from a source
+     * collection into a destination one, an unpaired last run is moved
+     **/
+    template<
+        typename RandomAccessIterator1,
+        typename RandomAccessIterator2,
+        typename Observer
+    >
+    void
+    merge_pass(
+        RandomAccessIterator1 begin,
+        RandomAccessIterator1 end,
+        RandomAccessIterator2 out,
+        size_t width,
+        Observer& observer
+    ) {
+        size_t size = std::distance(begin, end);
+        for (size_t offset = 0; offset < size; offset += 2 * width) {
+            auto first = std::next(begin, offset);
+            auto mid = std::next(first, std::min(width, size - offset));
+            auto last = std::next(first, std::min(2 * width, size - offset));
+            if (mid != last)
+                observer.merge(width, std::distance(mid, last));
+            out = algs::sort::merge::merge_move(first, mid, mid, last, out);
         }
     }
+
+    /**
+     * Bottom-up ping-pong merge sort with a caller-owned `scratch` buffer,
+     * reporting merged runs to an `observer`. Passes alternate between the
+     * collection and the buffer, so unlike sort_bottomup every pass moves
+     * each element once instead of copying it twice. Sorted elements are
+     * moved back after an odd number of passes
+     * NOTE: Stable
+     * NOTE: Uses std::distance(begin, end) elements of the scratch buffer
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    sort_bottomup_pingpong(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        scratch_buffer<typename std::iterator_traits<RandomAccessIterator>::value_type>& scratch,
+        Observer& observer
+    ) {
+        size_t size = std::distance(begin, end);
+        auto tmp_begin = scratch.get(size), tmp_end = tmp_begin + size;
+        bool in_tmp = false;
+        for (size_t width = 1; width < size; width *= 2, in_tmp = !in_tmp) {
+            if (in_tmp)
+                algs::sort::merge::merge_pass(tmp_begin, tmp_end, begin, width, observer);
+            else
+                algs::sort::merge::merge_pass(begin, end, tmp_begin, width, observer);
+        }
+        if (in_tmp)
+            std::move(tmp_begin, tmp_end, begin);
+    }
+
+    /**
+     * Bottom-up ping-pong merge sort, reporting merged runs to an `observer`
+     * NOTE: Stable
+     * NOTE: Uses temporary array of size std::distance(begin, end)
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    sort_bottomup_pingpong(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Observer& observer
+    ) {
+        scratch_buffer<typename std::iterator_traits<RandomAccessIterator>::value_type> scratch;
+        algs::sort::merge::sort_bottomup_pingpong(begin, end, scratch, observer);
+    }
+
+    /**
+     * Bottom-up ping-pong merge sort with a caller-owned `scratch` buffer
+     * NOTE: Stable
+     * NOTE: Uses std::distance(begin, end) elements of the scratch buffer
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    sort_bottomup_pingpong(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        scratch_buffer<typename std::iterator_traits<RandomAccessIterator>::value_type>& scratch
+    ) {
+        null_observer observer;
+        algs::sort::merge::sort_bottomup_pingpong(begin, end, scratch, observer);
+    }
+
+    /**
+     * Bottom-up ping-pong merge sort
+     * NOTE: Stable
+     * NOTE: Uses temporary array of size std::distance(begin, end)
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    sort_bottomup_pingpong(
+        RandomAccessIterator begin,
+        RandomAccessIterator end
+    ) {
+        null_observer observer;
+        algs::sort::merge::sort_bottomup_pingpong(begin, end, observer);
+    }
+
+    /**
+     * Exponential search of the first element greater than `key` in
+     * a sorted collection: probes elements 1, 3, 7, ... and then does a
+     * binary search between the last two probes. Takes O(log d)
+     * comparisons, where d is the distance to the found element
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename T,
+        typename Less
+    >
+    RandomAccessIterator
+    gallop_upper(
+        const T& key,
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Less less
+    ) {
+        size_t size = std::distance(begin, end), lo = 0, hi = 1;
+        while (hi <= size && !less(key, begin[hi - 1])) {
+            lo = hi;
+            hi = 2 * hi + 1;
+        }
+        return std::upper_bound(std::next(begin, lo), std::next(begin, std::min(hi, size)), key, less);
+    }
+
+    /**
+     * Exponential search of the first element not less than `key` in
+     * a sorted collection, see gallop_upper
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename T,
+        typename Less
+    >
+    RandomAccessIterator
+    gallop_lower(
+        const T& key,
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Less less
+    ) {
+        size_t size = std::distance(begin, end), lo = 0, hi = 1;
+        while (hi <= size && less(begin[hi - 1], key)) {
+            lo = hi;
+            hi = 2 * hi + 1;
+        }
+        return std::lower_bound(std::next(begin, lo), std::next(begin, std::min(hi, size)), key, less);
+    }
+
+    /**
+     * Merge a left run moved out to a temporary [left, left_end) with
+     * a right run [right, right_end) into `out`, which precedes the right
+     * run by the left run's size. Elements are merged one at a time until
+     * one run wins `min_gallop` times in a row, then merge switches to
+     * galloping: whole ranges of a run are found by exponential search
+     * and moved at once. `min_gallop` adapts between merges: it drops while
+     * galloping pays off and grows when galloping is left.
+     * Merging from the back is the same merge over reverse iterators with
+     * reversed `less`
+     * NOTE: Stable, equal elements of the left run go first
+     **/
+    template<
+        typename TmpIterator,
+        typename RandomAccessIterator,
+        typename Less
+    >
+    void
+    merge_galloping(
+        TmpIterator left,
+        TmpIterator left_end,
+        RandomAccessIterator right,
+        RandomAccessIterator right_end,
+        RandomAccessIterator out,
+        size_t& min_gallop,
+        Less less
+    ) {
+        const size_t MIN_GALLOP = 7;
+        while (left != left_end && right != right_end) {
+            size_t left_wins = 0, right_wins = 0;
+            while (left != left_end && right != right_end && std::max(left_wins, right_wins) < min_gallop) {
+                if (less(*right, *left)) {
+                    *out++ = std::move(*right++);
+                    ++right_wins;
+                    left_wins = 0;
+                } else {
+                    *out++ = std::move(*left++);
+                    ++left_wins;
+                    right_wins = 0;
+                }
+            }
+            while (left != left_end && right != right_end) {
+                auto left_next = algs::sort::merge::gallop_upper(*right, left, left_end, less);
+                size_t left_count = std::distance(left, left_next);
+                out = std::move(left, left_next, out);
+                left = left_next;
+                if (left == left_end)
+                    break;
+                *out++ = std::move(*right++);
+                if (right == right_end)
+                    break;
+                auto right_next = algs::sort::merge::gallop_lower(*left, right, right_end, less);
+                size_t right_count = std::distance(right, right_next);
+                out = std::move(right, right_next, out);
+                right = right_next;
+                if (right == right_end)
+                    break;
+                *out++ = std::move(*left++);
+                if (min_gallop > 1)
+                    --min_gallop;
+                if (left_count < MIN_GALLOP && right_count < MIN_GALLOP) {
+                    min_gallop += 2;
+                    break;
+                }
+            }
+        }
+        // the rest of the right run is already in place
+        std::move(left, left_end, out);
+    }
+
+    /**
+     * Find a natural run at the beginning of a collection: a non-descending
+     * or a strictly descending one, which is reversed. Strictness keeps
+     * the reversal stable
+     * NOTE: Returns the end of the run
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    RandomAccessIterator
+    natural_run(
+        RandomAccessIterator begin,
+        RandomAccessIterator end
+    ) {
+        if (std::distance(begin, end) < 2)
+            return end;
+        auto it = std::next(begin);
+        if (*it < *begin) {
+            while (std::next(it) != end && *std::next(it) < *it)
+                ++it;
+            std::reverse(begin, ++it);
+        } else {
+            while (std::next(it) != end && !(*std::next(it) < *it))
+                ++it;
+            ++it;
+        }
+        return it;
+    }
+
+    /**
+     * Extend a sorted [begin, sorted) to [begin, end) with a binary
+     * insertion sort: O(n log n) comparisons, O(n^2) moves
+     * NOTE: Stable, an element is inserted after equal ones
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    binary_insertion_sort(
+        RandomAccessIterator begin,
+        RandomAccessIterator sorted,
+        RandomAccessIterator end
+    ) {
+        for (auto it = sorted; it != end; ++it) {
+            auto position = std::upper_bound(begin, it, *it);
+            auto value = std::move(*it);
+            std::move_backward(position, it, std::next(it));
+            *position = std::move(value);
+        }
+    }
+
+    /**
+     * Minimal run length for natural merge sort of `size` elements:
+     * 32..64, so that size / min_run is a power of 2 or slightly less,
+     * which keeps the final merges balanced
+     **/
+    inline size_t
+    natural_min_run(
+        size_t size
+    ) {
+        size_t odd = 0;
+        while (size >= 64) {
+            odd |= size & 1;
+            size >>= 1;
+        }
+        return size + odd;
+    }
+
+    /**
+     * Natural merge sort (TimSort), reporting merged runs to an `observer`.
+     * Splits a collection into natural runs, strictly descending ones are
+     * reversed, and runs shorter than natural_min_run are extended with
+     * binary insertion sort. Runs are pushed to a stack, whose run lengths
+     * are kept growing faster than Fibonacci numbers by merging:
+     *   len[i-2] > len[i-1] + len[i], len[i-1] > len[i]
+     * so the stack is O(log n) deep and merged runs are of similar sizes.
+     * Merges skip prefix and suffix elements already in place, move the
+     * shorter run out to a temporary and gallop through long stretches
+     * taken from one run, see merge_galloping.
+     * O(n) for presorted input or a few sorted runs, O(n log n) otherwise
+     * NOTE: Stable
+     * NOTE: Uses temporary array of up to std::distance(begin, end) / 2
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    sort_natural(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Observer& observer
+    ) {
+        using value_type = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        auto less = [](const value_type& lhs, const value_type& rhs) { return lhs < rhs; };
+        auto greater = [](const value_type& lhs, const value_type& rhs) { return rhs < lhs; };
+
+        size_t size = std::distance(begin, end);
+        if (size < 2)
+            return;
+        size_t min_run = algs::sort::merge::natural_min_run(size);
+        size_t min_gallop = 7;
+        std::vector<std::pair<size_t, size_t>> runs; // offset and length
+        std::vector<value_type> tmp;
+
+        auto merge_at = [&](size_t i) {
+            auto first = std::next(begin, runs[i].first);
+            auto mid = std::next(first, runs[i].second);
+            auto last = std::next(mid, runs[i + 1].second);
+            observer.merge(runs[i].second, runs[i + 1].second);
+            runs[i].second += runs[i + 1].second;
+            runs.erase(std::next(runs.begin(), i + 1));
+
+            // elements of the left run not greater than the right one's first
+            // and of the right run not less than the left one's last stay
+            first = algs::sort::merge::gallop_upper(*mid, first, mid, less);
+            if (first == mid)
+                return;
+            last = algs::sort::merge::gallop_lower(*std::prev(mid), mid, last, less);
+            if (std::distance(first, mid) <= std::distance(mid, last)) {
+                tmp.assign(std::make_move_iterator(first), std::make_move_iterator(mid));
+                algs::sort::merge::merge_galloping(tmp.begin(), tmp.end(),
+                    mid, last, first, min_gallop, less);
+            } else {
+                using reverse = std::reverse_iterator<RandomAccessIterator>;
+                tmp.assign(std::make_move_iterator(mid), std::make_move_iterator(last));
+                algs::sort::merge::merge_galloping(tmp.rbegin(), tmp.rend(),
+                    reverse(mid), reverse(first), reverse(last), min_gallop, greater);
+            }
+        };
+
+        for (auto it = begin; it != end;) {
+            auto run_end = algs::sort::merge::natural_run(it, end);
+            if (size_t(std::distance(it, run_end)) < min_run) {
+                auto forced_end = std::next(it, std::min<size_t>(min_run, std::distance(it, end)));
+                algs::sort::merge::binary_insertion_sort(it, run_end, forced_end);
+                run_end = forced_end;
+            }
+            runs.emplace_back(std::distance(begin, it), std::distance(it, run_end));
+            it = run_end;
+
+            // restore invariants of the run stack
+            while (runs.size() > 1) {
+                size_t n = runs.size() - 2;
+                if ((n > 0 && runs[n - 1].second <= runs[n].second + runs[n + 1].second)
+                    || (n > 1 && runs[n - 2].second <= runs[n - 1].second + runs[n].second)) {
+                    if (runs[n - 1].second < runs[n + 1].second)
+                        --n;
+                } else if (runs[n].second > runs[n + 1].second)
+                    break;
+                merge_at(n);
+            }
+        }
+        while (runs.size() > 1) {
+            size_t n = runs.size() - 2;
+            if (n > 0 && runs[n - 1].second < runs[n + 1].second)
+                --n;
+            merge_at(n);
+        }
+    }
+
+    /**
+     * Natural merge sort (TimSort)
+     * NOTE: Stable
+     * NOTE: Uses temporary array of up to std::distance(begin, end) / 2
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    sort_natural(
+        RandomAccessIterator begin,
+        RandomAccessIterator end
+    ) {
+        null_observer observer;
+        algs::sort::merge::sort_natural(begin, end, observer);
+    }
+
+    /**
+     * Stable merge of sorted [begin, mid) and [mid, end) with a buffer,
+     * which must hold the shorter run. The shorter run is moved out to the
+     * buffer and merged with the other one in place, forward or backward,
+     * see merge_galloping
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename BufferIterator
+    >
+    void
+    merge_buffered(
+        RandomAccessIterator begin,
+        RandomAccessIterator mid,
+        RandomAccessIterator end,
+        BufferIterator buffer,
+        size_t& min_gallop
+    ) {
+        using value_type = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        auto less = [](const value_type& lhs, const value_type& rhs) { return lhs < rhs; };
+        auto greater = [](const value_type& lhs, const value_type& rhs) { return rhs < lhs; };
+
+        if (std::distance(begin, mid) <= std::distance(mid, end)) {
+            auto buffer_end = std::move(begin, mid, buffer);
+            algs::sort::merge::merge_galloping(buffer, buffer_end, mid, end, begin, min_gallop, less);
+        } else {
+            using reverse = std::reverse_iterator<RandomAccessIterator>;
+            using reverse_buffer = std::reverse_iterator<BufferIterator>;
+            auto buffer_end = std::move(mid, end, buffer);
+            algs::sort::merge::merge_galloping(reverse_buffer(buffer_end), reverse_buffer(buffer),
+                reverse(mid), reverse(begin), reverse(end), min_gallop, greater);
+        }
+    }
+
+    /**
+     * Stable block merge of sorted [begin, mid) and [mid, end) with
+     * a buffer of `block` elements and `tags` for (end - begin) / block
+     * blocks. Runs not longer than a block are merged through the buffer.
+     * Otherwise the full blocks of both runs, [begin + a0, mid) and
+     * [mid, end - b0) for the leftovers a0 < block and b0 < block, are:
+     *   - ordered by their first elements with a block selection sort,
+     *     ties are broken by tags: left run blocks first, in their order.
+     *     That is O(blocks^2) comparisons and O(end - begin) moves
+     *   - merged left to right: an unmerged rest of a block is merged
+     *     through the buffer with the next block of the other run, until
+     *     one of them is exhausted, and what is left becomes the rest.
+     *     Block order guarantees that merged elements are final (Kronrod)
+     * Then the leftovers are merged in through the buffer
+     * NOTE: Stable
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename BufferIterator
+    >
+    void
+    merge_blocks(
+        RandomAccessIterator begin,
+        RandomAccessIterator mid,
+        RandomAccessIterator end,
+        BufferIterator buffer,
+        size_t block,
+        std::vector<size_t>& tags,
+        size_t& min_gallop
+    ) {
+        size_t left_size = std::distance(begin, mid), right_size = std::distance(mid, end);
+        if (std::min(left_size, right_size) <= block) {
+            algs::sort::merge::merge_buffered(begin, mid, end, buffer, min_gallop);
+            return;
+        }
+
+        auto blocks_begin = std::next(begin, left_size % block);
+        auto blocks_end = std::prev(end, right_size % block);
+        size_t left_blocks = left_size / block, blocks = left_blocks + right_size / block;
+        auto block_at = [&](size_t index) {
+            return std::next(blocks_begin, index * block);
+        };
+        for (size_t i = 0; i < blocks; ++i)
+            tags[i] = i;
+
+        // block selection sort by (first element, tag)
+        for (size_t i = 0; i < blocks; ++i) {
+            size_t min = i;
+            for (size_t j = i + 1; j < blocks; ++j) {
+                if (*block_at(j) < *block_at(min)
+                    || (!(*block_at(min) < *block_at(j)) && tags[j] < tags[min]))
+                    min = j;
+            }
+            if (min != i) {
+                std::swap_ranges(block_at(i), block_at(i + 1), block_at(min));
+                std::swap(tags[i], tags[min]);
+            }
+        }
+
+        // local merges of the rest with blocks of the other run
+        auto rest_begin = block_at(0), rest_end = block_at(1);
+        bool rest_is_left = tags[0] < left_blocks;
+        for (size_t i = 1; i < blocks; ++i) {
+            bool is_left = tags[i] < left_blocks;
+            auto next = block_at(i), next_end = block_at(i + 1);
+            if (is_left == rest_is_left) {
+                rest_begin = next;
+                rest_end = next_end;
+                continue;
+            }
+            auto buffer_it = buffer, buffer_end = std::move(rest_begin, rest_end, buffer);
+            auto out = rest_begin;
+            while (buffer_it != buffer_end && next != next_end) {
+                // equal elements of the left run go first
+                if (rest_is_left ? *next < *buffer_it : !(*buffer_it < *next))
+                    *out++ = std::move(*next++);
+                else
+                    *out++ = std::move(*buffer_it++);
+            }
+            if (buffer_it == buffer_end) {
+                rest_begin = next;
+                rest_is_left = is_left;
+            } else {
+                // the other block is exhausted, the buffer fills it up to its end
+                rest_begin = out;
+                std::move(buffer_it, buffer_end, out);
+            }
+            rest_end = next_end;
+        }
+
+        if (begin != blocks_begin)
+            algs::sort::merge::merge_buffered(begin, blocks_begin, blocks_end, buffer, min_gallop);
+        if (blocks_end != end)
+            algs::sort::merge::merge_buffered(begin, blocks_end, end, buffer, min_gallop);
+    }
+
+    /**
+     * Stable block merge sort with O(sqrt(n)) extra memory, reporting merged
+     * runs to an `observer`. Runs of 16 elements are sorted with binary
+     * insertion sort and merged bottom-up with merge_blocks, using a buffer
+     * of sqrt(n) elements and sqrt(n) block tags.
+     * O(n log n) comparisons and moves: block selection sort takes
+     * O(blocks^2) = O(run length) comparisons per merge
+     * NOTE: Stable
+     * NOTE: Adjacent runs already in order are not merged
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    sort_block_merge(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Observer& observer
+    ) {
+        using value_type = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        const size_t RUN = 16;
+
+        size_t size = std::distance(begin, end);
+        if (size < 2)
+            return;
+        for (auto it = begin; it != end;) {
+            auto run_end = std::next(it, std::min(RUN, size_t(std::distance(it, end))));
+            algs::sort::merge::binary_insertion_sort(it, std::next(it), run_end);
+            it = run_end;
+        }
+        if (size <= RUN)
+            return;
+
+        size_t block = size_t(std::sqrt(double(size))) + 1;
+        std::vector<value_type> buffer(block);
+        std::vector<size_t> tags(size / block + 1);
+        size_t min_gallop = 7;
+        for (size_t width = RUN; width < size; width *= 2) {
+            for (size_t offset = 0; offset + width < size; offset += 2 * width) {
+                auto first = std::next(begin, offset);
+                auto mid = std::next(first, width);
+                auto last = std::next(first, std::min(2 * width, size - offset));
+                observer.merge(width, std::distance(mid, last));
+                if (*mid < *std::prev(mid))
+                    algs::sort::merge::merge_blocks(first, mid, last, buffer.begin(), block, tags, min_gallop);
+            }
+        }
+    }
+
+    /**
+     * Stable block merge sort with O(sqrt(n)) extra memory
+     * NOTE: Stable
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    sort_block_merge(
+        RandomAccessIterator begin,
+        RandomAccessIterator end
+    ) {
+        null_observer observer;
+        algs::sort::merge::sort_block_merge(begin, end, observer);
+    }
 } // namespace algs::sort::merge
 
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace algs::sort {
+    /**
+     * Observer of sort phases. Sorts accepting an `Observer&` report:
+     *   enter(), leave()   - entering and leaving a recursive call
+     *   partition(l, r)    - sizes of parts around a pivot
+     *   merge(l, r)        - lengths of merged runs
+     *   sift(levels)       - levels an element moved down a heap
+     *   h_pass(h, swaps)   - swaps done by an h-sorting pass
+     * null_observer ignores everything, so a sort called without an
+     * observer compiles to the same code as before
+     **/
+    struct null_observer {
+        void enter() {}
+        void leave() {}
+        void partition(size_t, size_t) {}
+        void merge(size_t, size_t) {}
+        void sift(size_t) {}
+        void h_pass(size_t, size_t) {}
+    };
+
+    /**
+     * Observer collecting events into an in-memory trace of up to
+     * `capacity` events. Events past the capacity are only counted,
+     * recursion depth is tracked for all of them
+     **/
+    class trace_observer {
+    public:
+        enum event_kind : uint8_t { PARTITION, MERGE, SIFT, H_PASS };
+
+        struct event {
+            event_kind kind;
+            uint32_t depth; // recursion depth when reported
+            uint64_t first; // left part, left run, levels or h
+            uint64_t second; // right part, right run or swaps
+        };
+
+        explicit trace_observer(size_t capacity = 1 << 16)
+            : mCapacity(capacity), mDepth(0), mMaxDepth(0), mDropped(0)
+        {}
+
+        void enter() {
+            if (++mDepth > mMaxDepth)
+                mMaxDepth = mDepth;
+        }
+
+        void leave() {
+            --mDepth;
+        }
+
+        void partition(size_t left, size_t right) {
+            record(PARTITION, left, right);
+        }
+
+        void merge(size_t left, size_t right) {
+            record(MERGE, left, right);
+        }
+
+        void sift(size_t levels) {
+            record(SIFT, levels, 0);
+        }
+
+        void h_pass(size_t h, size_t swaps) {
+            record(H_PASS, h, swaps);
+        }
+
+        const std::vector<event>& events() const {
+            return mEvents;
+        }
+
+        size_t max_depth() const {
+            return mMaxDepth;
+        }
+
+        // events not recorded because of the capacity
+        size_t dropped() const {
+            return mDropped;
+        }
+
+        void clear() {
+            mEvents.clear();
+            mDepth = mMaxDepth = mDropped = 0;
+        }
+
+        /**
+         * Print max depth and a line per recorded event
+         **/
+        friend std::ostream& operator<<(std::ostream& out, const trace_observer& trace) {
+            static const char *names[] = { "partition", "merge", "sift", "h_pass" };
+            out << "max depth: " << trace.mMaxDepth << ", events: " << trace.mEvents.size()
+                << ", dropped: " << trace.mDropped << std::endl;
+            for (const auto& e : trace.mEvents)
+                out << names[e.kind] << " depth " << e.depth << ": "
+                    << e.first << ' ' << e.second << std::endl;
+            return out;
+        }
+
+    private:
+        void record(event_kind kind, size_t first, size_t second) {
+            if (mEvents.size() < mCapacity)
+                mEvents.push_back({ kind, uint32_t(mDepth), first, second });
+            else
+                ++mDropped;
+        }
+
+        std::vector<event> mEvents;
+        size_t mCapacity, mDepth, mMaxDepth, mDropped;
+    };
+} // namespace algs::sort
@@ -0,0 +1,508 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "merge.hpp"
+#include "quicksort.hpp"
+#include "scratch.hpp"
+
+namespace algs::sort::parallel {
+    /**
+     * Number of threads to use: `threads` if set, hardware concurrency otherwise
+     **/
+    inline size_t
+    thread_count(
+        size_t threads = 0
+    ) {
+        if (threads == 0)
+            threads = std::thread::hardware_concurrency();
+        return std::max<size_t>(threads, 1);
+    }
+
+    /**
+     * Split [0, size) into `threads` contiguous ranges of almost equal size
+     * and call fn(index, range_begin, range_end) for each range in its own
+     * thread. The calling thread processes the last range
+     **/
+    template<
+        typename Fn
+    >
+    void
+    for_each_range(
+        size_t size,
+        size_t threads,
+        Fn fn
+    ) {
+        auto range_begin = [&](size_t index) {
+            return size * index / threads;
+        };
+        std::vector<std::thread> workers;
+        for (size_t index = 0; index + 1 < threads; ++index)
+            workers.emplace_back(fn, index, range_begin(index), range_begin(index + 1));
+        fn(threads - 1, range_begin(threads - 1), size);
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    /**
+     * Split a collection into `threads` contiguous chunks of almost equal
+     * size and call fn(index, chunk_begin, chunk_end) for each chunk in its
+     * own thread. The calling thread processes the last chunk
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Fn
+    >
+    void
+    for_each_chunk(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        size_t threads,
+        Fn fn
+    ) {
+        algs::sort::parallel::for_each_range(size_t(std::distance(begin, end)), threads,
+            [&](size_t index, size_t first, size_t last) {
+                fn(index, std::next(begin, first), std::next(begin, last));
+            });
+    }
+
+    /**
+     * Partition a collection in `threads` parallel blocks with
+     * partition_block(first, last), which partitions a block and returns
+     * its split. Blocks cover the collection contiguously, so after them
+     * the only misplaced elements are right parts of blocks left of the
+     * final split and left parts of blocks right of it. A cleanup phase
+     * swaps the k-th misplaced element on the left with the k-th one on
+     * the right, dividing the swaps evenly between threads again.
+     * O(n / threads) time, O(threads) memory
+     * NOTE: Returns the split between the left and right parts
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename BlockPartition
+    >
+    RandomAccessIterator
+    partition_blocks(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        size_t threads,
+        BlockPartition partition_block
+    ) {
+        using range = std::pair<RandomAccessIterator, RandomAccessIterator>;
+        const size_t BLOCK_SIZE = 1 << 16; // blocks are not smaller to be worth a thread
+
+        auto size = size_t(std::distance(begin, end));
+        threads = std::min(algs::sort::parallel::thread_count(threads), std::max<size_t>(size / BLOCK_SIZE, 1));
+        if (threads == 1)
+            return partition_block(begin, end);
+
+        std::vector<range> blocks(threads);
+        algs::sort::parallel::for_each_chunk(begin, end, threads,
+            [&](size_t index, RandomAccessIterator first, RandomAccessIterator last) {
+                blocks[index] = { first, partition_block(first, last) };
+            });
+        size_t left = 0;
+        for (const auto& block : blocks)
+            left += size_t(std::distance(block.first, block.second));
+        auto split = std::next(begin, left);
+
+        // misplaced right parts on the left of the split and left parts on its right
+        std::vector<range> misplaced_left, misplaced_right;
+        for (size_t index = 0; index < threads; ++index) {
+            auto block_end = index + 1 < threads ? blocks[index + 1].first : end;
+            auto block_split = blocks[index].second;
+            if (block_split < split)
+                misplaced_left.emplace_back(block_split, std::min(block_end, split));
+            if (split < block_split)
+                misplaced_right.emplace_back(std::max(blocks[index].first, split), block_split);
+        }
+        size_t misplaced = 0;
+        for (const auto& part : misplaced_left)
+            misplaced += size_t(std::distance(part.first, part.second));
+        if (misplaced == 0)
+            return split;
+
+        // position of `offset`-th misplaced element in `parts`
+        auto locate = [](const std::vector<range>& parts, size_t offset) {
+            size_t index = 0;
+            while (offset >= size_t(std::distance(parts[index].first, parts[index].second))) {
+                offset -= size_t(std::distance(parts[index].first, parts[index].second));
+                ++index;
+            }
+            return std::make_pair(index, std::next(parts[index].first, offset));
+        };
+        algs::sort::parallel::for_each_range(misplaced, std::min(threads, misplaced),
+            [&](size_t, size_t first, size_t last) {
+                auto [l, lit] = locate(misplaced_left, first);
+                auto [r, rit] = locate(misplaced_right, first);
+                for (size_t count = last - first; count > 0;) {
+                    auto step = std::min({ count,
+                        size_t(std::distance(lit, misplaced_left[l].second)),
+                        size_t(std::distance(rit, misplaced_right[r].second)) });
+                    rit = std::swap_ranges(lit, std::next(lit, step), rit);
+                    std::advance(lit, step);
+                    count -= step;
+                    if (count > 0 && lit == misplaced_left[l].second)
+                        lit = misplaced_left[++l].first;
+                    if (count > 0 && rit == misplaced_right[r].second)
+                        rit = misplaced_right[++r].first;
+                }
+            });
+        return split;
+    }
+
+    /**
+     * Partition a collection with `threads` threads (hardware concurrency
+     * by default), moving elements satisfying `predicate` to the left
+     * NOTE: Returns the first element not satisfying the predicate
+     * NOTE: Relative order of elements is not preserved
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Predicate
+    >
+    RandomAccessIterator
+    partition_if(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Predicate predicate,
+        size_t threads = 0
+    ) {
+        return algs::sort::parallel::partition_blocks(begin, end, threads,
+            [&](RandomAccessIterator first, RandomAccessIterator last) {
+                return std::partition(first, last, predicate);
+            });
+    }
+
+    /**
+     * Partition a collection around a pivot element with `threads` threads
+     * (hardware concurrency by default). Blocks are partitioned with vector
+     * instructions where quicksort::partition_vectorized would be
+     * NOTE: Uses first element as a pivot
+     * NOTE: New element order: (<=p) p (>p)
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    RandomAccessIterator
+    partition(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        size_t threads = 0
+    ) {
+        if (begin == end)
+            return begin;
+        auto pivot = *begin;
+        auto split = algs::sort::parallel::partition_blocks(std::next(begin), end, threads,
+            [&](RandomAccessIterator first, RandomAccessIterator last) {
+                if constexpr(algs::sort::simd::is_vectorizable_v<RandomAccessIterator>) {
+                    if (first == last)
+                        return first;
+                    auto data = &*first;
+                    auto middle = algs::sort::simd::partition(data, data + std::distance(first, last), pivot);
+                    return std::next(first, std::distance(data, middle));
+                } else
+                    return std::partition(first, last, [&](const auto& value) { return !(pivot < value); });
+            });
+        auto result = std::prev(split);
+        std::iter_swap(begin, result);
+        return result;
+    }
+
+    /**
+     * Find the value of k-th minimal element of a large collection with
+     * `threads` threads (hardware concurrency by default), leaving the
+     * collection intact.
+     * Like Floyd-Rivest select, each round takes two pivots from a sorted
+     * sample of candidate elements, so that k-th element most probably lies
+     * between them. Threads count candidates less than and equal to each
+     * pivot on their chunks, which is branchless and bound by memory
+     * bandwidth, and sample candidates between the pivots for the next
+     * round. A reduction of the counts either finds k-th element equal to
+     * a pivot or narrows candidates down to one of three ranges. Once
+     * candidates fit in cache (CACHE_SIZE elements), they are copied out
+     * and passed to a sequential introselect.
+     * Every round reads the whole collection and narrows candidates about
+     * SAMPLE_SIZE / GAP / 2 times, so a few rounds are enough for billions
+     * of elements
+     * NOTE: Requires k to be less than the size of the collection
+     * NOTE: Elements are copied between threads, values should be cheap to copy
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    typename std::iterator_traits<RandomAccessIterator>::value_type
+    select(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        size_t k,
+        size_t threads = 0
+    ) {
+        using value_type = typename std::iterator_traits<RandomAccessIterator>::value_type;
+        const size_t SAMPLE_SIZE = 4096;
+        const size_t GAP = 128; // sample ranks between k-th element and a pivot, ~2 deviations
+        const size_t CACHE_SIZE = 1 << 16;
+
+        auto size = size_t(std::distance(begin, end));
+        assert(k < size);
+        threads = std::min(algs::sort::parallel::thread_count(threads), std::max<size_t>(size / CACHE_SIZE, 1));
+
+        // candidates are elements in (lo, hi), bounds are absent at first
+        value_type lo{}, hi{};
+        bool has_lo = false, has_hi = false;
+        auto is_candidate = [&](const value_type& value) {
+            return (!has_lo || lo < value) & (!has_hi || value < hi);
+        };
+        size_t candidates = size;
+
+        std::mt19937 gen(size);
+        std::vector<value_type> sample;
+        auto sample_candidates = [&] {
+            // rejection sampling, candidates are a large part of the collection most probably
+            for (size_t i = 0; i < 64 * SAMPLE_SIZE && sample.size() < SAMPLE_SIZE; ++i) {
+                const auto& value = begin[std::uniform_int_distribution<size_t>(0, size - 1)(gen)];
+                if (is_candidate(value))
+                    sample.push_back(value);
+            }
+        };
+        if (size > CACHE_SIZE)
+            sample_candidates();
+
+        while (candidates > CACHE_SIZE && !sample.empty()) {
+            std::sort(sample.begin(), sample.end());
+            size_t rank = k * sample.size() / candidates;
+            value_type p1 = sample[rank > GAP ? rank - GAP : 0];
+            value_type p2 = sample[std::min(rank + GAP, sample.size() - 1)];
+
+            // [0] < p1, [1] <= p1, [2] < p2, [3] <= p2
+            std::vector<std::array<size_t, 4>> counts(threads);
+            std::vector<std::vector<value_type>> samples(threads);
+            double rate = std::min(1., double(SAMPLE_SIZE) * sample.size() / (2 * GAP + 1) / candidates);
+            algs::sort::parallel::for_each_chunk(begin, end, threads,
+                [&](size_t thread, RandomAccessIterator first, RandomAccessIterator last) {
+                    std::mt19937 gen(thread + candidates);
+                    std::geometric_distribution<size_t> skip(rate);
+                    std::array<size_t, 4> count = {};
+                    auto& sampled = samples[thread];
+                    size_t next_sample = skip(gen);
+                    for (; first != last; ++first) {
+                        const value_type& value = *first;
+                        bool candidate = is_candidate(value);
+                        bool above_p1 = p1 < value, below_p2 = value < p2;
+                        count[0] += candidate & (value < p1);
+                        count[1] += candidate & !above_p1;
+                        count[2] += candidate & below_p2;
+                        count[3] += candidate & !(p2 < value);
+                        if (candidate & above_p1 & below_p2 && next_sample-- == 0) {
+                            sampled.push_back(value);
+                            next_sample = skip(gen);
+                        }
+                    }
+                    counts[thread] = count;
+                });
+
+            std::array<size_t, 4> count = {};
+            for (const auto& thread : counts)
+                for (size_t i = 0; i < count.size(); ++i)
+                    count[i] += thread[i];
+            sample.clear();
+            if (k < count[0]) {
+                hi = p1;
+                has_hi = true;
+                candidates = count[0];
+                sample_candidates();
+            } else if (k < count[1]) {
+                return p1;
+            } else if (k < count[2]) {
+                lo = p1;
+                hi = p2;
+                has_lo = has_hi = true;
+                k -= count[1];
+                candidates = count[2] - count[1];
+                for (const auto& thread : samples)
+                    sample.insert(sample.end(), thread.begin(), thread.end());
+            } else if (k < count[3]) {
+                return p2;
+            } else {
+                lo = p2;
+                has_lo = true;
+                k -= count[3];
+                candidates -= count[3];
+                sample_candidates();
+            }
+        }
+
+        // candidates fit in cache: copy them out and select sequentially
+        std::vector<std::vector<value_type>> parts(threads);
+        algs::sort::parallel::for_each_chunk(begin, end, threads,
+            [&](size_t thread, RandomAccessIterator first, RandomAccessIterator last) {
+                std::copy_if(first, last, std::back_inserter(parts[thread]), is_candidate);
+            });
+        std::vector<value_type> rest;
+        for (const auto& part : parts)
+            rest.insert(rest.end(), part.begin(), part.end());
+        return *algs::sort::quicksort::introselect(rest.begin(), rest.end(), k);
+    }
+
+    /**
+     * Co-rank of `k` in a stable merge of sorted [left_begin, left_end) and
+     * [right_begin, right_end): numbers of left and right elements, i + j = k,
+     * among the first k merged elements. A binary search over i: left[i]
+     * is merged before right[j - 1] iff !(right[j - 1] < left[i]), which
+     * holds for small i and fails for large ones.
+     * O(log min(k, n)) comparisons
+     * NOTE: Equal elements of the left collection go first
+     **/
+    template<
+        typename RandomAccessIterator1,
+        typename RandomAccessIterator2
+    >
+    std::pair<size_t, size_t>
+    co_rank(
+        size_t k,
+        RandomAccessIterator1 left_begin,
+        RandomAccessIterator1 left_end,
+        RandomAccessIterator2 right_begin,
+        RandomAccessIterator2 right_end
+    ) {
+        size_t left_size = std::distance(left_begin, left_end);
+        size_t right_size = std::distance(right_begin, right_end);
+        assert(k <= left_size + right_size);
+
+        size_t lo = k > right_size ? k - right_size : 0, hi = std::min(k, left_size);
+        while (lo < hi) {
+            size_t i = lo + (hi - lo) / 2, j = k - i;
+            if (!(right_begin[j - 1] < left_begin[i]))
+                lo = i + 1;
+            else
+                hi = i;
+        }
+        return { lo, k - lo };
+    }
+
+    /**
+     * Stable merge moving sorted [left_begin, left_end) and [right_begin,
+     * right_end) to `out` with `threads` threads (hardware concurrency by
+     * default). The output is split into equal parts, co_rank finds the
+     * input ranges of each part, so parts are merged independently
+     * NOTE: Equal elements of the left collection go first
+     **/
+    template<
+        typename RandomAccessIterator1,
+        typename RandomAccessIterator2,
+        typename RandomAccessIteratorOut
+    >
+    void
+    merge_move(
+        RandomAccessIterator1 left_begin,
+        RandomAccessIterator1 left_end,
+        RandomAccessIterator2 right_begin,
+        RandomAccessIterator2 right_end,
+        RandomAccessIteratorOut out,
+        size_t threads = 0
+    ) {
+        const size_t PART_SIZE = 1 << 16; // parts are not smaller to be worth a thread
+
+        size_t size = std::distance(left_begin, left_end) + std::distance(right_begin, right_end);
+        threads = std::min(algs::sort::parallel::thread_count(threads), std::max<size_t>(size / PART_SIZE, 1));
+        algs::sort::parallel::for_each_range(size, threads,
+            [&](size_t, size_t first, size_t last) {
+                auto [left_first, right_first] = co_rank(first, left_begin, left_end, right_begin, right_end);
+                auto [left_last, right_last] = co_rank(last, left_begin, left_end, right_begin, right_end);
+                algs::sort::merge::merge_move(
+                    std::next(left_begin, left_first), std::next(left_begin, left_last),
+                    std::next(right_begin, right_first), std::next(right_begin, right_last),
+                    std::next(out, first));
+            });
+    }
+
+    /**
+     * Implementation of a parallel merge sort. DO NOT USE DIRECTLY
+     * Sorts [begin, end) into `other` if `into_other`, in place otherwise,
+     * like merge::sort_recursive_pingpong_impl: the left half is sorted by
+     * a forked thread, the right one by the current thread, then halves
+     * are merged with all `threads` by merge_move
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename RandomAccessIteratorOther
+    >
+    void
+    merge_sort_impl(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        RandomAccessIteratorOther other,
+        bool into_other,
+        size_t threads
+    ) {
+        const size_t SEQUENTIAL_SIZE = 1 << 16;
+
+        auto size = size_t(std::distance(begin, end));
+        if (threads < 2 || size < SEQUENTIAL_SIZE) {
+            null_observer observer;
+            algs::sort::merge::sort_recursive_pingpong_impl(begin, end, other, into_other, observer);
+            return;
+        }
+        auto mid = std::next(begin, size / 2);
+        auto other_mid = std::next(other, size / 2), other_end = std::next(other, size);
+        std::thread left(merge_sort_impl<RandomAccessIterator, RandomAccessIteratorOther>,
+            begin, mid, other, !into_other, threads / 2);
+        merge_sort_impl(mid, end, other_mid, !into_other, threads - threads / 2);
+        left.join();
+        if (into_other)
+            algs::sort::parallel::merge_move(begin, mid, mid, end, other, threads);
+        else
+            algs::sort::parallel::merge_move(other, other_mid, other_mid, other_end, begin, threads);
+    }
+
+    /**
+     * Parallel stable merge sort with a caller-owned `scratch` buffer and
+     * `threads` threads (hardware concurrency by default). Recursive halves
+     * are sorted by forked threads down to `threads` sequential ping-pong
+     * merge sorts, and every merge above them is split between threads by
+     * co-ranks, so all levels use all threads.
+     * O(n log n / threads + log^2 n) time
+     * NOTE: Stable
+     * NOTE: Uses std::distance(begin, end) elements of the scratch buffer
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    merge_sort(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        scratch_buffer<typename std::iterator_traits<RandomAccessIterator>::value_type>& scratch,
+        size_t threads = 0
+    ) {
+        auto tmp = scratch.get(std::distance(begin, end));
+        algs::sort::parallel::merge_sort_impl(begin, end, tmp, false, algs::sort::parallel::thread_count(threads));
+    }
+
+    /**
+     * Parallel stable merge sort with `threads` threads (hardware
+     * concurrency by default)
+     * NOTE: Stable
+     * NOTE: Uses temporary array of size std::distance(begin, end)
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    merge_sort(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        size_t threads = 0
+    ) {
+        scratch_buffer<typename std::iterator_traits<RandomAccessIterator>::value_type> scratch;
+        algs::sort::parallel::merge_sort(begin, end, scratch, threads);
+    }
+} // namespace algs::sort::parallel
@@ -1,4 +1,17 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
 #include <utility>
+#include <vector>
+
+#include "heap.hpp"
+#include "insertion.hpp"
+#include "observer.hpp"
+#include "simd.hpp"
 
 namespace algs::sort::quicksort {
     /**
@@ -66,7 +79,7 @@ namespace algs::sort::quicksort {
                 return false;
             }
         it = std::next(left);
-        while (it != right)
+        while (it < right) // pivots may be the same element
             if (*left <= *it && *it <= *right)
                 ++it;
             else {
@@ -75,7 +88,7 @@ namespace algs::sort::quicksort {
             }
         it = std::next(right);
         while (it != end)
-            if (*left < *it)
+            if (*right < *it)
                 ++it;
             else {
                 //std::cerr << "ccc " << *it << " " << *right << std::endl;
@@ -112,6 +125,31 @@ namespace algs::sort::quicksort {
         return more;
     }
 
+    /**
+     * Partition a collection around a pivot element with vector instructions
+     * for contiguous ranges of int32_t, int64_t, float and double when built
+     * with AVX2 or AVX-512, falls back to `partition` otherwise
+     * NOTE: Uses first element as a pivot
+     * NOTE: New element order: (<=p) p (>p)
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    RandomAccessIterator
+    partition_vectorized(
+        RandomAccessIterator begin,
+        RandomAccessIterator end
+    ) {
+        if constexpr(algs::sort::simd::is_vectorizable_v<RandomAccessIterator>) {
+            auto first = &*begin, last = first + std::distance(begin, end);
+            auto middle = algs::sort::simd::partition(std::next(first), last, *first);
+            auto pivot = std::next(begin, std::distance(first, middle) - 1);
+            std::iter_swap(begin, pivot);
+            return pivot;
+        } else
+            return algs::sort::quicksort::partition(begin, end);
+    }
+
     /**
      * Partition a collection around two pivots
      * NOTE: Uses first and last elements as pivots
@@ -125,8 +163,8 @@ namespace algs::sort::quicksort {
         RandomAccessIterator begin,
         RandomAccessIterator end
     ) {
-        if (end <= begin)
-            return std::make_pair(begin, end);
+        if (std::distance(begin, end) < 2)
+            return std::make_pair(begin, begin);
         auto p = begin; // left pivot
         auto q = std::prev(end); // right pivot
         if (*q < *p) // left pivot should be less than the right one
@@ -136,14 +174,14 @@ namespace algs::sort::quicksort {
         // [k,g] contains unpartitioned part of the collection
         // (g,q) contains elems greater than the second pivot
         auto l = std::next(begin);
-        auto g = std::prev(end);
+        auto g = std::prev(end, 2);
         for (auto k = l; k <= g; ++k) {
             if (*k < *p) { // skip elems less than the left pivot
                 std::iter_swap(k, l);
                 ++l;
                 //std::cout << "a:  "; for (auto it = begin; it != end; ++it) std::cout << *it << ' '; std::cout << std::endl;
-            } else if (*q <= *k) { // found element in the left part gte than the right pivot
-                while (k < g && *q < *g) // skip elems less than the right pivot
+            } else if (*q < *k) { // found element in the left part greater than the right pivot
+                while (k < g && *q < *g) // skip elems greater than the right pivot
                     --g;
                 std::iter_swap(k, g); // swap left greater elem with right less elem
                 //std::cout << "b1: "; for (auto it = begin; it != end; ++it) std::cout << *it << ' '; std::cout << std::endl;
@@ -162,11 +200,12 @@ namespace algs::sort::quicksort {
         return std::make_pair(l, g);
     }
 
-    // TODO: implement this
     /**
-     * Partition a collection around two pivots
-     * NOTE: Uses first and last elements as pivots
+     * Partition a collection into elements less than, equal to and
+     * greater than a pivot (Dijkstra's Dutch national flag)
+     * NOTE: Uses first element as a pivot
      * NOTE: New element order: (<p) (p p ... p ... p p)  (p<)
+     * NOTE: Returns first and last elements equal to the pivot
      **/
     template<
         typename RandomAccessIterator
@@ -176,28 +215,52 @@ namespace algs::sort::quicksort {
         RandomAccessIterator begin,
         RandomAccessIterator end
     ) {
-        return std::make_pair(begin, end);
+        if (end <= begin)
+            return std::make_pair(begin, end);
+        // [begin,lt) contains elems less than the pivot
+        // [lt,i) contains elems equal to the pivot, *lt is always the pivot
+        // [i,gt) contains unpartitioned part of the collection
+        // [gt,end) contains elems greater than the pivot
+        auto lt = begin;
+        auto i = std::next(begin);
+        auto gt = end;
+        while (i < gt) {
+            if (*i < *lt) {
+                std::iter_swap(lt, i);
+                ++lt;
+                ++i;
+            } else if (*lt < *i) {
+                --gt;
+                std::iter_swap(i, gt);
+            } else
+                ++i;
+        }
+        return std::make_pair(lt, std::prev(i));
     }
 
     /**
-     * Find k-th minimal element in a collection
+     * Find k-th minimal element in a collection, reporting
+     * partition sizes to an `observer`
      * NOTE: no implicit shuffle for future benching purposes
      **/
     template<
-        typename RandomAccessIterator
+        typename RandomAccessIterator,
+        typename Observer
     >
     RandomAccessIterator
     select(
         RandomAccessIterator begin,
         RandomAccessIterator end,
-        size_t k
+        size_t k,
+        Observer& observer
     ) {
         if (end < std::next(begin, k))
             return end;
 
         auto left = begin, right = end, it = std::next(begin, k);
         while (left != right) {
-            auto pivot = algs::sort::quicksort::partition(left, right);
+            auto pivot = algs::sort::quicksort::partition_vectorized(left, right);
+            observer.partition(std::distance(left, pivot), std::distance(pivot, right) - 1);
             if (pivot < it)
                 left = std::next(pivot);
             else if (it < pivot)
@@ -209,6 +272,48 @@ namespace algs::sort::quicksort {
         return end;
     }
 
+    /**
+     * Find k-th minimal element in a collection
+     * NOTE: no implicit shuffle for future benching purposes
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    RandomAccessIterator
+    select(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        size_t k
+    ) {
+        null_observer observer;
+        return algs::sort::quicksort::select(begin, end, k, observer);
+    }
+
+    /**
+     * Standart quicksort implementation, reporting recursion
+     * and partition sizes to an `observer`
+     * NOTE:: no implicit shuffle for future benching purposes
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    sort(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Observer& observer
+    ) {
+        if (end <= begin)
+            return;
+        observer.enter();
+        auto pivot = algs::sort::quicksort::partition_vectorized(begin, end);
+        observer.partition(std::distance(begin, pivot), std::distance(pivot, end) - 1);
+        algs::sort::quicksort::sort(begin, pivot, observer);
+        algs::sort::quicksort::sort(std::next(pivot), end, observer);
+        observer.leave();
+    }
+
     /**
      * Standart quicksort implementation.
      * NOTE:: no implicit shuffle for future benching purposes
@@ -221,11 +326,937 @@ namespace algs::sort::quicksort {
         RandomAccessIterator begin,
         RandomAccessIterator end
     ) {
-        if (end <= begin)
-            return;
-        auto pivot = algs::sort::quicksort::partition(begin, end);
-        algs::sort::quicksort::sort(begin, pivot);
-        algs::sort::quicksort::sort(std::next(pivot), end);
+        null_observer observer;
+        algs::sort::quicksort::sort(begin, end, observer);
     }
-}
 
+    /**
+     * Order three elements so that `b` holds their median
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    sort3(
+        RandomAccessIterator a,
+        RandomAccessIterator b,
+        RandomAccessIterator c
+    ) {
+        if (*b < *a)
+            std::iter_swap(a, b);
+        if (*c < *b) {
+            std::iter_swap(b, c);
+            if (*b < *a)
+                std::iter_swap(a, b);
+        }
+    }
+
+    /**
+     * Move a pivot candidate to the first element: median of the first,
+     * middle and last elements, or Tukey's ninther (median of three
+     * such medians) for ranges longer than `ninther_threshold`
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    choose_pivot(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        size_t ninther_threshold = 128
+    ) {
+        auto size = std::distance(begin, end);
+        auto mid = std::next(begin, size / 2), last = std::prev(end);
+        if (size_t(size) > ninther_threshold) {
+            auto step = size / 8;
+            sort3(begin, std::next(begin, step), std::next(begin, 2 * step));
+            sort3(std::prev(mid, step), mid, std::next(mid, step));
+            sort3(std::prev(last, 2 * step), std::prev(last, step), last);
+            sort3(std::next(begin, step), mid, std::prev(last, step));
+        } else
+            sort3(begin, mid, last);
+        std::iter_swap(begin, mid);
+    }
+
+    /**
+     * Implementation of an introsort. DO NOT USE DIRECTLY
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    introsort_impl(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        size_t depth_limit,
+        Observer& observer
+    ) {
+        const std::ptrdiff_t INSERTION_THRESHOLD = 16;
+
+        observer.enter();
+        while (std::distance(begin, end) > INSERTION_THRESHOLD) {
+            if (depth_limit == 0) { // too many bad pivots, O(n log n) guaranteed
+                algs::sort::heap::sort(begin, end, observer);
+                observer.leave();
+                return;
+            }
+            --depth_limit;
+            algs::sort::quicksort::choose_pivot(begin, end);
+            auto pivot = algs::sort::quicksort::partition_vectorized(begin, end);
+            auto left = std::distance(begin, pivot), right = std::distance(pivot, end) - 1;
+            observer.partition(left, right);
+            // recurse into the smaller part, so the stack is O(log n) deep
+            if (left < right) {
+                introsort_impl(begin, pivot, depth_limit, observer);
+                begin = std::next(pivot);
+            } else {
+                introsort_impl(std::next(pivot), end, depth_limit, observer);
+                end = pivot;
+            }
+        }
+        if (std::distance(begin, end) > 1)
+            algs::sort::insertion::sort_enhanced(begin, end);
+        observer.leave();
+    }
+
+    /**
+     * Introsort (Musser, 1997): quicksort with median-of-3 or ninther
+     * pivots, recursing into the smaller part only. Falls back to heap sort
+     * after 2*log2(n) levels of bad pivots and sorts small parts with
+     * insertion sort. Reports recursion, partition sizes and heap sifts
+     * to an `observer`
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    introsort(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Observer& observer
+    ) {
+        size_t depth_limit = 0;
+        for (auto size = std::distance(begin, end); size > 1; size /= 2)
+            depth_limit += 2;
+        algs::sort::quicksort::introsort_impl(begin, end, depth_limit, observer);
+    }
+
+    /**
+     * Introsort: O(n log n) worst case quicksort
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    introsort(
+        RandomAccessIterator begin,
+        RandomAccessIterator end
+    ) {
+        null_observer observer;
+        algs::sort::quicksort::introsort(begin, end, observer);
+    }
+
+    /**
+     * Implementation of a 3-way quicksort. DO NOT USE DIRECTLY
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    sort_three_way_impl(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Observer& observer
+    ) {
+        observer.enter();
+        while (std::distance(begin, end) > 1) {
+            algs::sort::quicksort::choose_pivot(begin, end);
+            auto part = algs::sort::quicksort::partition_three_way(begin, end);
+            auto left = std::distance(begin, part.first), right = std::distance(part.second, end) - 1;
+            observer.partition(left, right);
+            // elements equal to the pivot are in place, recurse into the smaller part
+            if (left < right) {
+                sort_three_way_impl(begin, part.first, observer);
+                begin = std::next(part.second);
+            } else {
+                sort_three_way_impl(std::next(part.second), end, observer);
+                end = part.first;
+            }
+        }
+        observer.leave();
+    }
+
+    /**
+     * 3-way quicksort: a collection with k distinct keys takes O(n log k)
+     * comparisons, so inputs with many duplicates sort in near linear time.
+     * Reports recursion and sizes of parts less and greater than a pivot
+     * to an `observer`
+     * NOTE: Uses median-of-3 or ninther pivots
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    sort_three_way(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Observer& observer
+    ) {
+        algs::sort::quicksort::sort_three_way_impl(begin, end, observer);
+    }
+
+    /**
+     * 3-way quicksort for collections with many duplicate keys
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    sort_three_way(
+        RandomAccessIterator begin,
+        RandomAccessIterator end
+    ) {
+        null_observer observer;
+        algs::sort::quicksort::sort_three_way(begin, end, observer);
+    }
+
+    /**
+     * Insertion sort giving up after `limit` element moves.
+     * Returns true if a collection got sorted
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    bool
+    partial_insertion_sort(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        size_t limit = 8
+    ) {
+        if (begin == end)
+            return true;
+        size_t moves = 0;
+        for (auto it = std::next(begin); it != end; ++it) {
+            auto curr = it, prev = std::prev(it);
+            if (*curr < *prev) {
+                auto value = std::move(*curr);
+                do {
+                    *curr = std::move(*prev);
+                    --curr;
+                } while (curr != begin && value < *--prev);
+                *curr = std::move(value);
+                moves += std::distance(curr, it);
+            }
+            if (moves > limit)
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * Branchless block partition (Edelkamp and Weiss, "BlockQuicksort", 2016).
+     * Scans a block of elements from each side storing offsets of misplaced
+     * ones, comparison results are added to counters instead of branched on.
+     * Then swaps misplaced elements pairwise. DO NOT USE DIRECTLY
+     * NOTE: Uses first element as a pivot, requires an element not less
+     *       than the pivot at the end of a collection
+     * NOTE: New element order: (<p) p (>=p)
+     * NOTE: Returns the pivot and whether a collection was partitioned already
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    std::pair<RandomAccessIterator, bool>
+    partition_block(
+        RandomAccessIterator begin,
+        RandomAccessIterator end
+    ) {
+        const size_t BLOCK_SIZE = 64; // offsets fit into a byte
+
+        auto pivot = std::move(*begin);
+        auto first = begin, last = end;
+        // find the first pair of misplaced elements, bounded by the precondition
+        while (*++first < pivot)
+            ;
+        if (std::prev(first) == begin)
+            while (first < last && !(*--last < pivot))
+                ;
+        else
+            while (!(*--last < pivot))
+                ;
+        bool partitioned = first >= last;
+        if (!partitioned) {
+            std::iter_swap(first, last);
+            ++first;
+            // [begin,first) contains elems less than the pivot
+            // [first,last) contains unpartitioned part of the collection
+            // [last,end) contains elems not less than the pivot
+            // offsets of misplaced elems are relative to the block bases
+            alignas(64) unsigned char offsets_l[BLOCK_SIZE], offsets_r[BLOCK_SIZE];
+            auto base_l = first, base_r = last;
+            size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+            while (first < last) {
+                // scan a full block from each side, split the rest if both are empty
+                size_t unknown = std::distance(first, last);
+                size_t split_l = num_l == 0 ? (num_r == 0 ? unknown / 2 : unknown) : 0;
+                size_t split_r = num_r == 0 ? unknown - split_l : 0;
+                size_t count_l = std::min(split_l, BLOCK_SIZE);
+                size_t count_r = std::min(split_r, BLOCK_SIZE);
+                for (size_t i = 0; i < count_l; ++i, ++first) {
+                    offsets_l[num_l] = (unsigned char)(i);
+                    num_l += !(*first < pivot);
+                }
+                for (size_t i = 1; i <= count_r; ++i) {
+                    offsets_r[num_r] = (unsigned char)(i);
+                    num_r += *--last < pivot;
+                }
+                size_t num = std::min(num_l, num_r);
+                for (size_t i = 0; i < num; ++i)
+                    std::iter_swap(std::next(base_l, offsets_l[start_l + i]),
+                                   std::prev(base_r, offsets_r[start_r + i]));
+                num_l -= num;
+                num_r -= num;
+                start_l += num;
+                start_r += num;
+                if (num_l == 0) {
+                    start_l = 0;
+                    base_l = first;
+                }
+                if (num_r == 0) {
+                    start_r = 0;
+                    base_r = last;
+                }
+            }
+            // move misplaced elems left in one block to the middle
+            if (num_l > 0) {
+                while (num_l > 0)
+                    std::iter_swap(std::next(base_l, offsets_l[start_l + --num_l]), --last);
+                first = last;
+            }
+            while (num_r > 0)
+                std::iter_swap(std::prev(base_r, offsets_r[start_r + --num_r]), first++);
+        }
+        auto pivot_pos = std::prev(first);
+        *begin = std::move(*pivot_pos);
+        *pivot_pos = std::move(pivot);
+        return std::make_pair(pivot_pos, partitioned);
+    }
+
+    /**
+     * Partition a collection putting elements equal to the pivot to the left.
+     * DO NOT USE DIRECTLY
+     * NOTE: Uses first element as a pivot, requires an element equal to
+     *       the pivot before the collection, so no elems are less than it
+     * NOTE: New element order: (==p) p (>p)
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    RandomAccessIterator
+    partition_equal(
+        RandomAccessIterator begin,
+        RandomAccessIterator end
+    ) {
+        auto pivot = std::move(*begin);
+        auto first = begin, last = end;
+        while (pivot < *--last)
+            ;
+        if (std::next(last) == end)
+            while (first < last && !(pivot < *++first))
+                ;
+        else
+            while (!(pivot < *++first))
+                ;
+        while (first < last) {
+            std::iter_swap(first, last);
+            while (pivot < *--last)
+                ;
+            while (!(pivot < *++first))
+                ;
+        }
+        *begin = std::move(*last);
+        *last = std::move(pivot);
+        return last;
+    }
+
+    /**
+     * Implementation of a pattern-defeating quicksort. DO NOT USE DIRECTLY
+     * NOTE: `leftmost` is false when an element before `begin` is not greater
+     *       than any element of the collection
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    pdqsort_impl(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        size_t bad_allowed,
+        bool leftmost,
+        Observer& observer
+    ) {
+        const std::ptrdiff_t INSERTION_THRESHOLD = 24;
+        const std::ptrdiff_t NINTHER_THRESHOLD = 128;
+
+        observer.enter();
+        while (true) {
+            auto size = std::distance(begin, end);
+            if (size < INSERTION_THRESHOLD) {
+                if (size > 1)
+                    algs::sort::insertion::sort_enhanced(begin, end);
+                break;
+            }
+
+            // median of 3 or ninther to the first element, greater one to the last
+            auto mid = std::next(begin, size / 2), last = std::prev(end);
+            if (size > NINTHER_THRESHOLD) {
+                sort3(begin, mid, last);
+                sort3(std::next(begin), std::prev(mid), std::prev(last));
+                sort3(std::next(begin, 2), std::next(mid), std::prev(last, 2));
+                sort3(std::prev(mid), mid, std::next(mid));
+                std::iter_swap(begin, mid);
+            } else
+                sort3(mid, begin, last);
+
+            // the pivot equals an element before: no elems are less, skip equal ones
+            if (!leftmost && !(*std::prev(begin) < *begin)) {
+                auto pivot = algs::sort::quicksort::partition_equal(begin, end);
+                observer.partition(std::distance(begin, pivot), std::distance(pivot, end) - 1);
+                begin = std::next(pivot);
+                continue;
+            }
+
+            auto part = algs::sort::quicksort::partition_block(begin, end);
+            auto pivot = part.first;
+            auto left = std::distance(begin, pivot), right = std::distance(pivot, end) - 1;
+            observer.partition(left, right);
+
+            if (left < size / 8 || right < size / 8) {
+                // too many bad pivots, O(n log n) guaranteed
+                if (--bad_allowed == 0) {
+                    algs::sort::heap::sort(begin, end, observer);
+                    break;
+                }
+                // break up patterns by swapping elems into pivot candidate positions
+                if (left >= INSERTION_THRESHOLD) {
+                    std::iter_swap(begin, std::next(begin, left / 4));
+                    std::iter_swap(std::prev(pivot), std::prev(pivot, left / 4));
+                    if (left > NINTHER_THRESHOLD) {
+                        std::iter_swap(std::next(begin), std::next(begin, left / 4 + 1));
+                        std::iter_swap(std::next(begin, 2), std::next(begin, left / 4 + 2));
+                        std::iter_swap(std::prev(pivot, 2), std::prev(pivot, left / 4 + 1));
+                        std::iter_swap(std::prev(pivot, 3), std::prev(pivot, left / 4 + 2));
+                    }
+                }
+                if (right >= INSERTION_THRESHOLD) {
+                    std::iter_swap(std::next(pivot), std::next(pivot, right / 4 + 1));
+                    std::iter_swap(std::prev(end), std::prev(end, right / 4));
+                    if (right > NINTHER_THRESHOLD) {
+                        std::iter_swap(std::next(pivot, 2), std::next(pivot, right / 4 + 2));
+                        std::iter_swap(std::next(pivot, 3), std::next(pivot, right / 4 + 3));
+                        std::iter_swap(std::prev(end, 2), std::prev(end, right / 4 + 1));
+                        std::iter_swap(std::prev(end, 3), std::prev(end, right / 4 + 2));
+                    }
+                }
+            } else if (part.second
+                       && algs::sort::quicksort::partial_insertion_sort(begin, pivot)
+                       && algs::sort::quicksort::partial_insertion_sort(std::next(pivot), end))
+                break; // a balanced, already partitioned collection is likely sorted
+
+            // recurse into the smaller part, so the stack is O(log n) deep
+            if (left < right) {
+                pdqsort_impl(begin, pivot, bad_allowed, leftmost, observer);
+                begin = std::next(pivot);
+                leftmost = false;
+            } else {
+                pdqsort_impl(std::next(pivot), end, bad_allowed, false, observer);
+                end = pivot;
+            }
+        }
+        observer.leave();
+    }
+
+    /**
+     * Pattern-defeating quicksort (Peters, 2021) with branchless block
+     * partitioning. Takes O(n) on sorted and reverse sorted inputs and
+     * O(n log k) on inputs with k distinct keys; swaps elements around
+     * after unbalanced partitions to break up adversarial patterns and
+     * falls back to heap sort after log2(n) of them. Reports recursion,
+     * partition sizes and heap sifts to an `observer`
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    pdqsort(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Observer& observer
+    ) {
+        size_t bad_allowed = 1;
+        for (auto size = std::distance(begin, end); size > 1; size /= 2)
+            ++bad_allowed;
+        algs::sort::quicksort::pdqsort_impl(begin, end, bad_allowed, true, observer);
+    }
+
+    /**
+     * Pattern-defeating quicksort: O(n log n) worst case quicksort without
+     * branch mispredictions when partitioning
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    pdqsort(
+        RandomAccessIterator begin,
+        RandomAccessIterator end
+    ) {
+        null_observer observer;
+        algs::sort::quicksort::pdqsort(begin, end, observer);
+    }
+
+    /**
+     * Move pivot candidates for a dual-pivot partition to the first and the
+     * last elements: the 2nd and the 4th of five evenly spaced samples
+     * NOTE: Requires at least 16 elements
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    choose_dual_pivots(
+        RandomAccessIterator begin,
+        RandomAccessIterator end
+    ) {
+        auto size = std::distance(begin, end);
+        auto seventh = size / 8 + size / 64 + 1;
+        auto e3 = std::next(begin, size / 2);
+        RandomAccessIterator e[] = {
+            std::prev(e3, 2 * seventh), std::prev(e3, seventh), e3,
+            std::next(e3, seventh), std::next(e3, 2 * seventh)
+        };
+        // optimal sorting network for 5 elements
+        static const int network[][2] = {
+            { 0, 1 }, { 3, 4 }, { 2, 4 }, { 2, 3 }, { 0, 3 },
+            { 0, 2 }, { 1, 4 }, { 1, 3 }, { 1, 2 }
+        };
+        for (const auto& pair : network)
+            if (*e[pair[1]] < *e[pair[0]])
+                std::iter_swap(e[pair[0]], e[pair[1]]);
+        std::iter_swap(begin, e[1]);
+        std::iter_swap(std::prev(end), e[3]);
+    }
+
+    /**
+     * Implementation of a dual-pivot quicksort. DO NOT USE DIRECTLY
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    sort_dual_pivot_impl(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Observer& observer
+    ) {
+        const std::ptrdiff_t INSERTION_THRESHOLD = 32;
+
+        observer.enter();
+        while (std::distance(begin, end) > INSERTION_THRESHOLD) {
+            algs::sort::quicksort::choose_dual_pivots(begin, end);
+            auto part = algs::sort::quicksort::partition_dual_pivot(begin, end);
+            observer.partition(std::distance(begin, part.first), std::distance(part.second, end) - 1);
+            // elems between equal pivots are equal too
+            auto middle_end = *part.first < *part.second ? part.second : std::next(part.first);
+            std::pair<RandomAccessIterator, RandomAccessIterator> parts[] = {
+                { begin, part.first },
+                { std::next(part.first), middle_end },
+                { std::next(part.second), end }
+            };
+            // recurse into two smaller parts, so the stack is O(log n) deep
+            auto largest = std::max_element(std::begin(parts), std::end(parts),
+                [](const auto& lhs, const auto& rhs) {
+                    return std::distance(lhs.first, lhs.second) < std::distance(rhs.first, rhs.second);
+                });
+            for (auto it = std::begin(parts); it != std::end(parts); ++it)
+                if (it != largest)
+                    sort_dual_pivot_impl(it->first, it->second, observer);
+            begin = largest->first;
+            end = largest->second;
+        }
+        if (std::distance(begin, end) > 1)
+            algs::sort::insertion::sort_enhanced(begin, end);
+        observer.leave();
+    }
+
+    /**
+     * Dual-pivot quicksort (Yaroslavskiy, 2009) on top of
+     * partition_dual_pivot. Takes pivots from a sorted sample of five,
+     * sorts small parts with insertion sort and skips the middle part when
+     * pivots are equal. Reports recursion and sizes of parts less than the
+     * left and greater than the right pivot to an `observer`
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    sort_dual_pivot(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        Observer& observer
+    ) {
+        algs::sort::quicksort::sort_dual_pivot_impl(begin, end, observer);
+    }
+
+    /**
+     * Dual-pivot quicksort: fewer memory scans than a single pivot one
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    void
+    sort_dual_pivot(
+        RandomAccessIterator begin,
+        RandomAccessIterator end
+    ) {
+        null_observer observer;
+        algs::sort::quicksort::sort_dual_pivot(begin, end, observer);
+    }
+
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    RandomAccessIterator
+    select_median_of_medians(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        size_t k,
+        Observer& observer
+    );
+
+    /**
+     * Median of medians of groups of five (Blum, Floyd, Pratt, Rivest and
+     * Tarjan, 1973): not less than 3/10 and not greater than 7/10 of elements.
+     * Moves group medians to the front of a collection
+     * NOTE: Requires at least 5 elements
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    RandomAccessIterator
+    median_of_medians(
+        RandomAccessIterator begin,
+        RandomAccessIterator end
+    ) {
+        auto medians = begin;
+        for (auto group = begin; std::distance(group, end) >= 5; std::advance(group, 5)) {
+            algs::sort::insertion::sort(group, std::next(group, 5));
+            std::iter_swap(medians++, std::next(group, 2));
+        }
+        null_observer observer;
+        return algs::sort::quicksort::select_median_of_medians(
+            begin, medians, size_t(std::distance(begin, medians)) / 2, observer);
+    }
+
+    /**
+     * Find k-th minimal element in a collection in O(n) worst case time
+     * with median of medians pivots, reporting partition sizes to an
+     * `observer`
+     * NOTE: Elements equal to a pivot are partitioned 3-way, so many
+     *       duplicates do not make it quadratic
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    RandomAccessIterator
+    select_median_of_medians(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        size_t k,
+        Observer& observer
+    ) {
+        const std::ptrdiff_t INSERTION_THRESHOLD = 16;
+
+        if (std::distance(begin, end) <= std::ptrdiff_t(k))
+            return end;
+        auto left = begin, right = end, it = std::next(begin, k);
+        while (std::distance(left, right) > INSERTION_THRESHOLD) {
+            std::iter_swap(left, algs::sort::quicksort::median_of_medians(left, right));
+            auto part = algs::sort::quicksort::partition_three_way(left, right);
+            observer.partition(std::distance(left, part.first), std::distance(part.second, right) - 1);
+            if (it < part.first)
+                right = part.first;
+            else if (part.second < it)
+                left = std::next(part.second);
+            else
+                return it;
+        }
+        if (std::distance(left, right) > 1)
+            algs::sort::insertion::sort_enhanced(left, right);
+        return it;
+    }
+
+    /**
+     * Find k-th minimal element in a collection in O(n) worst case time
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    RandomAccessIterator
+    select_median_of_medians(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        size_t k
+    ) {
+        null_observer observer;
+        return algs::sort::quicksort::select_median_of_medians(begin, end, k, observer);
+    }
+
+    /**
+     * Introselect (Musser, 1997): quickselect with median-of-3 or ninther
+     * pivots while a part containing k-th element shrinks to 3/4 at least
+     * every two partitions, median of medians select after that. So it is
+     * as fast as quickselect on typical inputs and O(n) in the worst case.
+     * Reports partition sizes to an `observer`
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    RandomAccessIterator
+    introselect(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        size_t k,
+        Observer& observer
+    ) {
+        const std::ptrdiff_t INSERTION_THRESHOLD = 16;
+
+        if (std::distance(begin, end) <= std::ptrdiff_t(k))
+            return end;
+        auto left = begin, right = end, it = std::next(begin, k);
+        auto checkpoint = std::distance(left, right);
+        for (size_t steps = 1; std::distance(left, right) > INSERTION_THRESHOLD; ++steps) {
+            algs::sort::quicksort::choose_pivot(left, right);
+            auto pivot = algs::sort::quicksort::partition_vectorized(left, right);
+            observer.partition(std::distance(left, pivot), std::distance(pivot, right) - 1);
+            if (pivot < it)
+                left = std::next(pivot);
+            else if (it < pivot)
+                right = pivot;
+            else
+                return pivot;
+            if (steps % 2 == 0) {
+                if (std::distance(left, right) > checkpoint / 4 * 3) // progress stalls
+                    return algs::sort::quicksort::select_median_of_medians(
+                        left, right, size_t(std::distance(left, it)), observer);
+                checkpoint = std::distance(left, right);
+            }
+        }
+        if (std::distance(left, right) > 1)
+            algs::sort::insertion::sort_enhanced(left, right);
+        return it;
+    }
+
+    /**
+     * Introselect: find k-th minimal element in O(n) worst case time
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    RandomAccessIterator
+    introselect(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        size_t k
+    ) {
+        null_observer observer;
+        return algs::sort::quicksort::introselect(begin, end, k, observer);
+    }
+
+    /**
+     * Implementation of a Floyd-Rivest select on [left,right] indices.
+     * DO NOT USE DIRECTLY
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    void
+    select_floyd_rivest_impl(
+        RandomAccessIterator a,
+        std::ptrdiff_t left,
+        std::ptrdiff_t right,
+        std::ptrdiff_t k,
+        Observer& observer
+    ) {
+        const std::ptrdiff_t SAMPLE_THRESHOLD = 600;
+
+        while (left < right) {
+            if (right - left > SAMPLE_THRESHOLD) {
+                // narrow down to a sample expected to contain k-th element
+                double n = double(right - left + 1), i = double(k - left + 1);
+                double z = std::log(n), s = 0.5 * std::exp(2 * z / 3);
+                double sd = 0.5 * std::sqrt(z * s * (n - s) / n) * (i < n / 2 ? -1 : 1);
+                auto sample_left = std::max(left, std::ptrdiff_t(double(k) - i * s / n + sd));
+                auto sample_right = std::min(right, std::ptrdiff_t(double(k) + (n - i) * s / n + sd));
+                select_floyd_rivest_impl(a, sample_left, sample_right, k, observer);
+            }
+            // partition around k-th element, sentinels at both ends
+            auto pivot = a[k];
+            auto i = left, j = right;
+            std::iter_swap(a + left, a + k);
+            if (pivot < a[right])
+                std::iter_swap(a + right, a + left);
+            while (i < j) {
+                std::iter_swap(a + i, a + j);
+                ++i;
+                --j;
+                while (a[i] < pivot)
+                    ++i;
+                while (pivot < a[j])
+                    --j;
+            }
+            if (!(a[left] < pivot) && !(pivot < a[left]))
+                std::iter_swap(a + left, a + j);
+            else
+                std::iter_swap(a + ++j, a + right);
+            observer.partition(size_t(j - left), size_t(right - j));
+            if (j <= k)
+                left = j + 1;
+            if (k <= j)
+                right = j - 1;
+        }
+    }
+
+    /**
+     * Floyd-Rivest select (1975): partitions around elements selected from
+     * a sample of size ~n^(2/3), which brackets k-th element tightly, so
+     * it takes about n + min(k, n-k) comparisons on large collections.
+     * Reports partition sizes to an `observer`
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    RandomAccessIterator
+    select_floyd_rivest(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        size_t k,
+        Observer& observer
+    ) {
+        auto size = std::distance(begin, end);
+        if (size <= std::ptrdiff_t(k))
+            return end;
+        algs::sort::quicksort::select_floyd_rivest_impl(begin, 0, size - 1, std::ptrdiff_t(k), observer);
+        return std::next(begin, k);
+    }
+
+    /**
+     * Floyd-Rivest select: find k-th minimal element in a large collection
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    RandomAccessIterator
+    select_floyd_rivest(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        size_t k
+    ) {
+        null_observer observer;
+        return algs::sort::quicksort::select_floyd_rivest(begin, end, k, observer);
+    }
+
+    /**
+     * Implementation of a multi-select. DO NOT USE DIRECTLY
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename RankIterator,
+        typename Observer
+    >
+    void
+    multi_select_impl(
+        RandomAccessIterator base,
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        RankIterator first_rank,
+        RankIterator last_rank,
+        Observer& observer
+    ) {
+        while (first_rank != last_rank) {
+            // the middle rank splits the rest in halves
+            auto middle_rank = std::next(first_rank, std::distance(first_rank, last_rank) / 2);
+            auto it = algs::sort::quicksort::introselect(
+                begin, end, *middle_rank - size_t(std::distance(base, begin)), observer);
+            multi_select_impl(base, begin, it, first_rank, middle_rank, observer);
+            begin = std::next(it);
+            first_rank = std::next(middle_rank);
+        }
+    }
+
+    /**
+     * Find elements of all `ranks` in a collection at once, reporting
+     * partition sizes to an `observer`. Each requested element is put in
+     * place and a collection is partitioned around it.
+     * Selects the middle rank with introselect and descends into the parts
+     * with the ranks below and above it, so m ranks take O(n log m) time
+     * in the worst case instead of O(n m) for separate selects
+     * NOTE: Returns iterators in the order of `ranks`, `end` for ranks
+     *       out of a collection
+     **/
+    template<
+        typename RandomAccessIterator,
+        typename Observer
+    >
+    std::vector<RandomAccessIterator>
+    multi_select(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        const std::vector<size_t>& ranks,
+        Observer& observer
+    ) {
+        auto size = size_t(std::distance(begin, end));
+        std::vector<size_t> sorted;
+        for (auto rank : ranks)
+            if (rank < size)
+                sorted.push_back(rank);
+        std::sort(sorted.begin(), sorted.end());
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+        algs::sort::quicksort::multi_select_impl(begin, begin, end, sorted.begin(), sorted.end(), observer);
+
+        std::vector<RandomAccessIterator> result;
+        for (auto rank : ranks)
+            result.push_back(rank < size ? std::next(begin, rank) : end);
+        return result;
+    }
+
+    /**
+     * Find elements of all `ranks` in a collection at once,
+     * e.g. several percentiles
+     **/
+    template<
+        typename RandomAccessIterator
+    >
+    std::vector<RandomAccessIterator>
+    multi_select(
+        RandomAccessIterator begin,
+        RandomAccessIterator end,
+        const std::vector<size_t>& ranks
+    ) {
+        null_observer observer;
+        return algs::sort::quicksort::multi_select(begin, end, ranks, observer);
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace algs::sort {
+    /**
+     * Reusable scratch memory for sorts needing a temporary collection.
+     * A caller owning a buffer passes it to many sorts, so memory is
+     * allocated and faulted in once instead of on every sort.
+     * Trivial types are not initialized at all, other types are
+     * default-constructed once when the buffer grows and are reused
+     * as moved-from values afterwards.
+     * With `huge_pages` buffers of at least HUGE_PAGE_SIZE bytes are
+     * mmap-ed with MAP_HUGETLB, or advised for transparent huge pages
+     * with MADV_HUGEPAGE if no huge pages are reserved. That saves TLB
+     * misses and page faults on large buffers
+     * NOTE: Contents are not preserved when a buffer grows
+     * NOTE: Huge pages are only used on Linux
+     **/
+    template<typename T>
+    class scratch_buffer {
+    public:
+        static constexpr size_t HUGE_PAGE_SIZE = size_t(2) << 20;
+
+        explicit scratch_buffer(bool huge_pages = false)
+            : mHugePages(huge_pages)
+        {}
+
+        scratch_buffer(const scratch_buffer&) = delete;
+        scratch_buffer& operator=(const scratch_buffer&) = delete;
+
+        ~scratch_buffer() {
+            release();
+        }
+
+        /**
+         * Get `size` elements ready to be assigned to, growing the buffer
+         * if needed
+         **/
+        T *get(size_t size) {
+            reserve(size);
+            if constexpr(!IS_TRIVIAL) {
+                for (; mConstructed < size; ++mConstructed)
+                    new (mpData + mConstructed) T();
+            }
+            return mpData;
+        }
+
+        /**
+         * Allocate memory for at least `capacity` elements ahead of sorts
+         **/
+        void reserve(size_t capacity) {
+            if (capacity <= mCapacity)
+                return;
+            release();
+            allocate(capacity);
+        }
+
+        size_t capacity() const {
+            return mCapacity;
+        }
+
+        // true if memory is mmap-ed for huge pages
+        bool huge_pages() const {
+            return mMappedBytes != 0;
+        }
+
+    private:
+        static constexpr bool IS_TRIVIAL =
+            std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>;
+
+        void allocate(size_t capacity) {
+#ifdef __linux__
+            size_t bytes = capacity * sizeof(T);
+            if (mHugePages && bytes >= HUGE_PAGE_SIZE) {
+                size_t length = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+                void *pMemory = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if (pMemory == MAP_FAILED) {
+                    pMemory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                    if (pMemory != MAP_FAILED)
+                        madvise(pMemory, length, MADV_HUGEPAGE);
+                }
+                if (pMemory != MAP_FAILED) {
+                    mpData = static_cast<T *>(pMemory);
+                    mCapacity = length / sizeof(T);
+                    mMappedBytes = length;
+                    return;
+                }
+            }
+#endif
+            mpData = std::allocator<T>().allocate(capacity);
+            mCapacity = capacity;
+        }
+
+        void release() {
+            if (mpData == nullptr)
+                return;
+            if constexpr(!IS_TRIVIAL)
+                std::destroy_n(mpData, mConstructed);
+            mConstructed = 0;
+#ifdef __linux__
+            if (mMappedBytes != 0) {
+                munmap(mpData, mMappedBytes);
+                mMappedBytes = 0;
+            } else
+#endif
+                std::allocator<T>().deallocate(mpData, mCapacity);
+            mpData = nullptr;
+            mCapacity = 0;
+        }
+
+        T *mpData = nullptr;
+        size_t mCapacity = 0;
+        size_t mConstructed = 0; // live elements of non-trivial types
+        size_t mMappedBytes = 0;
+        bool mHugePages;
+    };
+} // namespace algs::sort
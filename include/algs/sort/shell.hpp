@@ -1,5 +1,7 @@
 #include <iterator>
 
+#include "observer.hpp"
+
 namespace algs::sort::shell {
     template<typename RandomAccessIterator>
     bool
@@ -16,10 +18,16 @@ namespace algs::sort::shell {
         return true;
     }
 
-    template<typename RandomAccessIterator>
+    /**
+     * Shell sort with Knuth's 3h+1 gaps, reporting
+     * swaps of each h-sorting pass to an `observer`
+     **/
+    template<typename RandomAccessIterator,
+             typename Observer>
     void
     sort(RandomAccessIterator begin,
-         RandomAccessIterator end)
+         RandomAccessIterator end,
+         Observer& observer)
     {
         using difference_type = typename std::iterator_traits<RandomAccessIterator>::difference_type;
 
@@ -29,17 +37,29 @@ namespace algs::sort::shell {
             h = 3 * h + 1;
 
         for (; h > 0; h /= 3) {
+            size_t swaps = 0;
             for (auto it = std::next(begin, h); it < end; ++it) {
                 for (auto curr = it, prev = std::prev(it, h);
                      prev >= begin && *curr < *prev;
                      curr = prev, prev = std::prev(prev, h)) {
                     std::iter_swap(curr, prev);
+                    ++swaps;
                 }
             }
+            observer.h_pass(h, swaps);
 #ifdef TEST
             ASSERT_TRUE(is_h_sorted(begin, end, h));
 #endif // TEST
         }
     }
+
+    template<typename RandomAccessIterator>
+    void
+    sort(RandomAccessIterator begin,
+         RandomAccessIterator end)
+    {
+        null_observer observer;
+        algs::sort::shell::sort(begin, end, observer);
+    }
 } // namespace algs::sort::shell
 
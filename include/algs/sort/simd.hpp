@@ -0,0 +1,304 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace algs::sort::simd {
+    /**
+     * Scalar partition of [first, last) around a `pivot` value
+     * NOTE: New element order: (<=p) (>p)
+     * NOTE: Returns the first element greater than the pivot
+     **/
+    template<
+        typename T
+    >
+    T *
+    partition_scalar(
+        T *first,
+        T *last,
+        T pivot
+    ) {
+        while (true) {
+            while (first != last && !(pivot < *first))
+                ++first;
+            while (first != last && pivot < *std::prev(last))
+                --last;
+            if (first == last)
+                return first;
+            std::iter_swap(first, --last);
+            ++first;
+        }
+    }
+
+    /**
+     * In-place vectorized partition of [first, last) around a `pivot` value.
+     * Vectors from both ends are saved to registers first, which leaves a
+     * vector of free space on each side. Then each loaded vector is compared
+     * with the pivot, its elements not greater than the pivot are written to
+     * the left free space, and the rest to the right free space. The next
+     * vector is loaded from the side with less free space, so both sides
+     * always have room for a whole vector
+     * NOTE: New element order: (<=p) (>p)
+     * NOTE: Returns the first element greater than the pivot
+     * NOTE: NaNs are not greater than anything, so they go to the left
+     **/
+    template<
+        typename Ops
+    >
+    typename Ops::value_type *
+    partition_vector(
+        typename Ops::value_type *first,
+        typename Ops::value_type *last,
+        typename Ops::value_type pivot
+    ) {
+        using value_type = typename Ops::value_type;
+        const size_t N = Ops::LANES;
+
+        if (size_t(last - first) < 2 * N)
+            return algs::sort::simd::partition_scalar(first, last, pivot);
+
+        auto pivots = Ops::broadcast(pivot);
+        auto saved_left = Ops::load(first);
+        auto saved_right = Ops::load(last - N);
+        // [first,wl) contains elems not greater than the pivot
+        // [wl,l) and [r,wr) is free space
+        // [l,r) contains unpartitioned part of the collection
+        // [wr,last) contains elems greater than the pivot
+        value_type *l = first + N, *r = last - N;
+        value_type *wl = first, *wr = last;
+        auto store = [&](auto v) {
+            auto mask = Ops::greater(v, pivots);
+            size_t greater = size_t(__builtin_popcount(mask));
+            Ops::store(wl, wr, v, mask);
+            wl += N - greater;
+            wr -= greater;
+        };
+        while (size_t(r - l) >= N) {
+            if (l - wl <= wr - r) {
+                auto v = Ops::load(l);
+                l += N;
+                store(v);
+            } else {
+                r -= N;
+                store(Ops::load(r));
+            }
+        }
+        while (l != r) {
+            value_type value = l - wl <= wr - r ? *l++ : *--r;
+            if (pivot < value)
+                *--wr = value;
+            else
+                *wl++ = value;
+        }
+        // exactly two vectors of free space left
+        store(saved_left);
+        store(saved_right);
+        return wl;
+    }
+
+#if defined(__AVX512F__)
+    /**
+     * AVX-512 operations: compress-stores write selected lanes contiguously
+     **/
+    template<typename T> struct avx512;
+
+    template<>
+    struct avx512<int32_t> {
+        using value_type = int32_t;
+        static const size_t LANES = 16;
+        static __m512i load(const int32_t *p) { return _mm512_loadu_si512(p); }
+        static __m512i broadcast(int32_t x) { return _mm512_set1_epi32(x); }
+        static __mmask16 greater(__m512i v, __m512i p) { return _mm512_cmpgt_epi32_mask(v, p); }
+        static void store(int32_t *left, int32_t *right, __m512i v, __mmask16 mask) {
+            _mm512_mask_compressstoreu_epi32(left, __mmask16(~mask), v);
+            _mm512_mask_compressstoreu_epi32(right - __builtin_popcount(mask), mask, v);
+        }
+    };
+
+    template<>
+    struct avx512<int64_t> {
+        using value_type = int64_t;
+        static const size_t LANES = 8;
+        static __m512i load(const int64_t *p) { return _mm512_loadu_si512(p); }
+        static __m512i broadcast(int64_t x) { return _mm512_set1_epi64(x); }
+        static __mmask8 greater(__m512i v, __m512i p) { return _mm512_cmpgt_epi64_mask(v, p); }
+        static void store(int64_t *left, int64_t *right, __m512i v, __mmask8 mask) {
+            _mm512_mask_compressstoreu_epi64(left, __mmask8(~mask), v);
+            _mm512_mask_compressstoreu_epi64(right - __builtin_popcount(mask), mask, v);
+        }
+    };
+
+    template<>
+    struct avx512<float> {
+        using value_type = float;
+        static const size_t LANES = 16;
+        static __m512 load(const float *p) { return _mm512_loadu_ps(p); }
+        static __m512 broadcast(float x) { return _mm512_set1_ps(x); }
+        static __mmask16 greater(__m512 v, __m512 p) { return _mm512_cmp_ps_mask(v, p, _CMP_GT_OQ); }
+        static void store(float *left, float *right, __m512 v, __mmask16 mask) {
+            _mm512_mask_compressstoreu_ps(left, __mmask16(~mask), v);
+            _mm512_mask_compressstoreu_ps(right - __builtin_popcount(mask), mask, v);
+        }
+    };
+
+    template<>
+    struct avx512<double> {
+        using value_type = double;
+        static const size_t LANES = 8;
+        static __m512d load(const double *p) { return _mm512_loadu_pd(p); }
+        static __m512d broadcast(double x) { return _mm512_set1_pd(x); }
+        static __mmask8 greater(__m512d v, __m512d p) { return _mm512_cmp_pd_mask(v, p, _CMP_GT_OQ); }
+        static void store(double *left, double *right, __m512d v, __mmask8 mask) {
+            _mm512_mask_compressstoreu_pd(left, __mmask8(~mask), v);
+            _mm512_mask_compressstoreu_pd(right - __builtin_popcount(mask), mask, v);
+        }
+    };
+
+#endif
+
+#if defined(__AVX2__)
+    /**
+     * Permutations moving lanes with a clear mask bit to the front and
+     * lanes with a set bit to the back, keeping their order. Indices of
+     * 32-bit lanes are packed into nibbles of a 32-bit word
+     **/
+    template<size_t LANES>
+    struct permutation_table {
+        uint32_t packed[1 << LANES];
+
+        constexpr permutation_table()
+            : packed()
+        {
+            const size_t WIDTH = 8 / LANES; // 32-bit lanes per lane
+            for (size_t mask = 0; mask < (1 << LANES); ++mask) {
+                size_t out = 0;
+                for (int greater = 0; greater < 2; ++greater)
+                    for (size_t lane = 0; lane < LANES; ++lane)
+                        if (((mask >> lane) & 1) == size_t(greater))
+                            for (size_t i = 0; i < WIDTH; ++i, ++out)
+                                packed[mask] |= uint32_t(lane * WIDTH + i) << (4 * out);
+            }
+        }
+    };
+
+    template<size_t LANES>
+    inline constexpr permutation_table<LANES> PERMUTATIONS{};
+
+    /**
+     * AVX2 operations: lanes are permuted in a register and the whole
+     * vector is written to both sides, extra lanes land in free space
+     **/
+    template<typename T>
+    struct avx2_base {
+        using value_type = T;
+        static const size_t LANES = 32 / sizeof(T);
+
+        static __m256i load(const T *p) {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        }
+
+        static void store(T *left, T *right, __m256i v, unsigned mask) {
+            auto indices = _mm256_srlv_epi32(
+                _mm256_set1_epi32(int(PERMUTATIONS<LANES>.packed[mask])),
+                _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28));
+            indices = _mm256_and_si256(indices, _mm256_set1_epi32(0xF));
+            v = _mm256_permutevar8x32_epi32(v, indices);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(left), v);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(right - LANES), v);
+        }
+    };
+
+    template<typename T> struct avx2;
+
+    template<>
+    struct avx2<int32_t> : avx2_base<int32_t> {
+        static __m256i broadcast(int32_t x) { return _mm256_set1_epi32(x); }
+        static unsigned greater(__m256i v, __m256i p) {
+            return unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, p))));
+        }
+    };
+
+    template<>
+    struct avx2<int64_t> : avx2_base<int64_t> {
+        static __m256i broadcast(int64_t x) { return _mm256_set1_epi64x(x); }
+        static unsigned greater(__m256i v, __m256i p) {
+            return unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(v, p))));
+        }
+    };
+
+    template<>
+    struct avx2<float> : avx2_base<float> {
+        static __m256i broadcast(float x) { return _mm256_castps_si256(_mm256_set1_ps(x)); }
+        static unsigned greater(__m256i v, __m256i p) {
+            return unsigned(_mm256_movemask_ps(
+                _mm256_cmp_ps(_mm256_castsi256_ps(v), _mm256_castsi256_ps(p), _CMP_GT_OQ)));
+        }
+    };
+
+    template<>
+    struct avx2<double> : avx2_base<double> {
+        static __m256i broadcast(double x) { return _mm256_castpd_si256(_mm256_set1_pd(x)); }
+        static unsigned greater(__m256i v, __m256i p) {
+            return unsigned(_mm256_movemask_pd(
+                _mm256_cmp_pd(_mm256_castsi256_pd(v), _mm256_castsi256_pd(p), _CMP_GT_OQ)));
+        }
+    };
+
+#endif
+
+#if defined(__AVX512F__)
+    template<typename T>
+    using vector_ops = avx512<T>;
+#elif defined(__AVX2__)
+    template<typename T>
+    using vector_ops = avx2<T>;
+#endif
+
+    /**
+     * True for contiguous iterators over int32_t, int64_t, float or double
+     * when built with AVX2 or AVX-512 (e.g. -march=native)
+     **/
+    template<
+        typename Iterator,
+        typename T = typename std::iterator_traits<Iterator>::value_type
+    >
+    inline constexpr bool is_vectorizable_v =
+#if defined(__AVX2__) || defined(__AVX512F__)
+        (std::is_same_v<T, int32_t> || std::is_same_v<T, int64_t>
+            || std::is_same_v<T, float> || std::is_same_v<T, double>)
+        && (std::is_pointer_v<Iterator> || std::is_same_v<Iterator, typename std::vector<T>::iterator>);
+#else
+        false;
+#endif
+
+    /**
+     * Partition [first, last) around a `pivot` value, vectorized when
+     * possible
+     * NOTE: New element order: (<=p) (>p)
+     * NOTE: Returns the first element greater than the pivot
+     **/
+    template<
+        typename T
+    >
+    T *
+    partition(
+        T *first,
+        T *last,
+        T pivot
+    ) {
+#if defined(__AVX2__) || defined(__AVX512F__)
+        if constexpr(is_vectorizable_v<T *>)
+            return algs::sort::simd::partition_vector<vector_ops<T>>(first, last, pivot);
+        else
+#endif
+            return algs::sort::simd::partition_scalar(first, last, pivot);
+    }
+} // namespace algs::sort::simd
@@ -1,5 +1,8 @@
 #include <stdexcept>
 
+#include "memory.hpp"
+#include "profile.hpp"
+
 namespace algs::tree::avl {
 
 // TODO: removal&rebalancing after removal
@@ -162,13 +165,20 @@ public:
         return root() ? root()->height() : 0;
     }
 
+    /**
+     * Returns heap footprint of nodes and allocation counters
+     **/
+    memory_stats memory_usage() const {
+        return mAllocator.stats(sizeof(*this));
+    }
+
 protected:
     void clear(node_type *pNode) {
         if (pNode == nullptr)
             return;
         clear(pNode->mpLeft);
         clear(pNode->mpRight);
-        delete pNode;
+        mAllocator.destroy(pNode);
     }
 
     node_type *find(node_type *pNode, const Key& key) {
@@ -213,15 +223,13 @@ protected:
 
     node_type *insert(node_type *pNode, node_type *pParent, Key key, Value value, node_type **ppNew) {
         if (pNode == nullptr)
-            return *ppNew = new node_type(key, value, pParent);
+            return *ppNew = mAllocator.create(key, value, pParent);
         else if (key < pNode->mData.first)
             pNode->mpLeft = insert(pNode->mpLeft, pNode, key, value, ppNew);
         else if (pNode->mData.first < key)
             pNode->mpRight = insert(pNode->mpRight, pNode, key, value, ppNew);
-        else {
+        else // existing key, *ppNew stays nullptr: nothing to rebalance
             pNode->mData.second = value;
-            *ppNew = pNode;
-        }
         return pNode;
     }
 
@@ -407,6 +415,7 @@ protected:
 
 private:
     node_type *mpRoot;
+    node_allocator<node_type> mAllocator;
 };
 
 template<typename Key, typename Value>
@@ -438,6 +447,13 @@ public:
         print(out, this->root(), 0);
     }
 
+    /**
+     * Shape statistics with balance factors as tags
+     **/
+    shape_profile profile() {
+        return algs::tree::profile(this->root(), [](node_type *pNode) { return int(pNode->mBalance); });
+    }
+
 private:
     void print(std::ostream& out, node_type *pNode, int depth) {
         if (pNode)
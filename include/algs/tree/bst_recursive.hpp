@@ -1,5 +1,8 @@
 #include <stdexcept>
 
+#include "memory.hpp"
+#include "profile.hpp"
+
 namespace algs::tree::bst {
 
 // TODO: iterators instead in_order/in_order_reverse methods
@@ -184,7 +187,14 @@ public:
      * Returns tree height
      **/
     size_t height() {
-        return root() ? height(root()) : 0;
+        return root() ? root()->height() : 0;
+    }
+
+    /**
+     * Returns heap footprint of nodes and allocation counters
+     **/
+    memory_stats memory_usage() const {
+        return mAllocator.stats(sizeof(*this));
     }
 
 protected:
@@ -193,7 +203,7 @@ protected:
             return;
         clear(pNode->mpLeft);
         clear(pNode->mpRight);
-        delete pNode;
+        mAllocator.destroy(pNode);
     }
 
     node_type *find(node_type *pNode, const Key& key) {
@@ -304,7 +314,7 @@ protected:
 
     node_type *insert(node_type *pNode, node_type *pParent, Key key, Value value, node_type **ppNew) {
         if (pNode == nullptr)
-            return *ppNew = new node_type(key, value, pParent);
+            return *ppNew = mAllocator.create(key, value, pParent);
         else if (key < pNode->mData.first)
             pNode->mpLeft = insert(pNode->mpLeft, pNode, key, value, ppNew);
         else if (pNode->mData.first < key)
@@ -318,7 +328,7 @@ protected:
 
     node_type *insert_root(node_type *pNode, node_type *pParent, Key key, Value value) {
         if (pNode == nullptr) {
-            pNode = new node_type(key, value, pParent);
+            pNode = mAllocator.create(key, value, pParent);
         } else if (key < pNode->mData.first) {
             pNode->mpLeft = insert_root(pNode->mpLeft, pNode, key, value);
             pNode = rotate_right(pNode);
@@ -364,7 +374,7 @@ protected:
             }
             if (pNewNode)
                 pNewNode->mpParent = pNode->mpParent;
-            delete pNode;
+            mAllocator.destroy(pNode);
             return pNewNode;
         }
     }
@@ -400,6 +410,7 @@ protected:
 
 private:
     node_type *mpRoot;
+    node_allocator<node_type> mAllocator;
 };
 
 template<typename Key, typename Value>
@@ -431,6 +442,13 @@ public:
         print(out, this->root(), 0);
     }
 
+    /**
+     * Shape statistics
+     **/
+    shape_profile profile() {
+        return algs::tree::profile(this->root());
+    }
+
 private:
     void print(std::ostream& out, node_type *pNode, int depth) {
         if (pNode)
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <utility>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace algs::tree {
+
+/**
+ * Heap footprint of a container's nodes and its allocation counters.
+ * NOTE: Allocator figures are exact for glibc malloc (usable chunk size
+ *       and a size_t chunk header), other allocators are assumed to add
+ *       nothing to requested sizes
+ **/
+struct memory_stats {
+    size_t allocations = 0; // nodes allocated during container lifetime
+    size_t frees = 0; // nodes freed during container lifetime
+    size_t live_nodes = 0;
+    size_t node_bytes = 0; // sizeof a node
+    size_t live_bytes = 0; // bytes requested for live nodes
+    size_t usable_bytes = 0; // bytes reserved by the allocator for live nodes
+    size_t header_bytes = 0; // allocator bookkeeping for live nodes
+    size_t container_bytes = 0; // the container object itself
+
+    // bytes reserved but not requested, i.e. rounding to allocator size classes
+    size_t slack_bytes() const {
+        return usable_bytes - live_bytes;
+    }
+
+    size_t total_bytes() const {
+        return container_bytes + usable_bytes + header_bytes;
+    }
+
+    // heap bytes per node including allocator slack and headers
+    double bytes_per_node() const {
+        return live_nodes ? double(usable_bytes + header_bytes) / live_nodes : 0.;
+    }
+
+    friend std::ostream& operator<<(std::ostream& out, const memory_stats& stats) {
+        return out << "allocations " << stats.allocations << ", frees " << stats.frees
+            << ", live nodes " << stats.live_nodes << " of " << stats.node_bytes << " bytes"
+            << ", live bytes " << stats.live_bytes << ", slack " << stats.slack_bytes()
+            << ", headers " << stats.header_bytes << ", total " << stats.total_bytes()
+            << " (" << stats.bytes_per_node() << " per node)";
+    }
+};
+
+/**
+ * Allocates nodes with new/delete and counts allocations.
+ * Usable size is queried once: nodes are of the same size,
+ * so malloc puts them into the same size class
+ **/
+template<typename Node>
+class node_allocator {
+public:
+    template<typename... Args>
+    Node *create(Args&&... args) {
+        Node *pNode = new Node(std::forward<Args>(args)...);
+        ++mAllocations;
+        if (mUsableSize == 0)
+            mUsableSize = usable_size(pNode);
+        return pNode;
+    }
+
+    void destroy(Node *pNode) {
+        delete pNode;
+        ++mFrees;
+    }
+
+    memory_stats stats(size_t container_bytes) const {
+        memory_stats result;
+        result.allocations = mAllocations;
+        result.frees = mFrees;
+        result.live_nodes = mAllocations - mFrees;
+        result.node_bytes = sizeof(Node);
+        result.live_bytes = result.live_nodes * sizeof(Node);
+        result.usable_bytes = result.live_nodes * (mUsableSize ? mUsableSize : sizeof(Node));
+        result.header_bytes = result.live_nodes * HEADER_BYTES;
+        result.container_bytes = container_bytes;
+        return result;
+    }
+
+private:
+#ifdef __GLIBC__
+    static constexpr size_t HEADER_BYTES = sizeof(size_t);
+
+    static size_t usable_size(Node *pNode) {
+        return malloc_usable_size(pNode);
+    }
+#else
+    static constexpr size_t HEADER_BYTES = 0;
+
+    static size_t usable_size(Node *) {
+        return sizeof(Node);
+    }
+#endif
+
+    size_t mAllocations = 0;
+    size_t mFrees = 0;
+    size_t mUsableSize = 0;
+};
+
+} // namespace algs::tree
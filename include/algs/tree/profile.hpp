@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace algs::tree {
+
+/**
+ * Shape of a binary search tree and the cost of searching it.
+ * Depths start from 0 at the root; a search for a key at depth d does
+ * d+1 key comparisons, an unsuccessful search ending at a null link
+ * of depth d does d comparisons (3-way comparisons count as one)
+ **/
+struct shape_profile {
+    size_t size = 0;
+    size_t height = 0;
+    std::vector<size_t> depth_histogram; // nodes per depth
+    size_t internal_path_length = 0; // sum of node depths
+    size_t external_path_length = 0; // sum of null link depths, I + 2n
+    size_t min_null_depth = 0; // shallowest null link
+    std::map<int, size_t> tag_histogram; // nodes per tag, e.g. colors or balance factors
+
+    double avg_successful_comparisons() const {
+        return size ? double(internal_path_length + size) / size : 0.;
+    }
+
+    size_t worst_successful_comparisons() const {
+        return height;
+    }
+
+    double avg_unsuccessful_comparisons() const {
+        return double(external_path_length) / (size + 1);
+    }
+
+    size_t worst_unsuccessful_comparisons() const {
+        return height;
+    }
+
+    friend std::ostream& operator<<(std::ostream& out, const shape_profile& profile) {
+        out << "size " << profile.size << ", height " << profile.height
+            << ", internal path length " << profile.internal_path_length << std::endl
+            << "successful search: avg " << profile.avg_successful_comparisons()
+            << ", worst " << profile.worst_successful_comparisons() << " comparisons" << std::endl
+            << "unsuccessful search: avg " << profile.avg_unsuccessful_comparisons()
+            << ", best " << profile.min_null_depth
+            << ", worst " << profile.worst_unsuccessful_comparisons() << " comparisons" << std::endl;
+        for (size_t depth = 0; depth < profile.depth_histogram.size(); ++depth)
+            out << "depth " << depth << ": " << profile.depth_histogram[depth] << std::endl;
+        for (const auto& tag : profile.tag_histogram)
+            out << "tag " << tag.first << ": " << tag.second << std::endl;
+        return out;
+    }
+};
+
+/**
+ * Profile a tree in one iterative O(n) pass with an O(height) stack.
+ * `tag(pNode)` classifies nodes for shape_profile::tag_histogram,
+ * nullptr leaves it empty
+ **/
+template<typename Node, typename TagFn>
+shape_profile profile(Node *pRoot, [[maybe_unused]] TagFn tag) {
+    shape_profile result;
+    if (pRoot == nullptr)
+        return result;
+    result.min_null_depth = static_cast<size_t>(-1);
+    std::vector<std::pair<Node *, size_t>> stack = { { pRoot, 0 } };
+    while (!stack.empty()) {
+        auto [pNode, depth] = stack.back();
+        stack.pop_back();
+        ++result.size;
+        result.height = std::max(result.height, depth + 1);
+        if (result.depth_histogram.size() <= depth)
+            result.depth_histogram.resize(depth + 1, 0);
+        ++result.depth_histogram[depth];
+        result.internal_path_length += depth;
+        if constexpr(!std::is_null_pointer_v<TagFn>)
+            ++result.tag_histogram[tag(pNode)];
+        for (Node *pChild : { pNode->mpLeft, pNode->mpRight }) {
+            if (pChild)
+                stack.emplace_back(pChild, depth + 1);
+            else {
+                result.external_path_length += depth + 1;
+                result.min_null_depth = std::min(result.min_null_depth, depth + 1);
+            }
+        }
+    }
+    return result;
+}
+
+template<typename Node>
+shape_profile profile(Node *pRoot) {
+    return algs::tree::profile(pRoot, nullptr);
+}
+
+} // namespace algs::tree
@@ -1,5 +1,8 @@
 #include <stdexcept>
 
+#include "memory.hpp"
+#include "profile.hpp"
+
 namespace algs::tree::rb {
 
 // TODO: removal&rebalancing after removal
@@ -169,13 +172,20 @@ public:
         return root() ? root()->height() : 0;
     }
 
+    /**
+     * Returns heap footprint of nodes and allocation counters
+     **/
+    memory_stats memory_usage() const {
+        return mAllocator.stats(sizeof(*this));
+    }
+
 protected:
     void clear(node_type *pNode) {
         if (pNode == nullptr)
             return;
         clear(pNode->mpLeft);
         clear(pNode->mpRight);
-        delete pNode;
+        mAllocator.destroy(pNode);
     }
 
     node_type *find(node_type *pNode, const Key& key) {
@@ -220,15 +230,13 @@ protected:
 
     node_type *insert(node_type *pNode, node_type *pParent, Key key, Value value, node_type **ppNew) {
         if (pNode == nullptr)
-            return *ppNew = new node_type(key, value, pParent);
+            return *ppNew = mAllocator.create(key, value, pParent);
         else if (key < pNode->mData.first)
             pNode->mpLeft = insert(pNode->mpLeft, pNode, key, value, ppNew);
         else if (pNode->mData.first < key)
             pNode->mpRight = insert(pNode->mpRight, pNode, key, value, ppNew);
-        else {
+        else // existing key, *ppNew stays nullptr: nothing to rebalance
             pNode->mData.second = value;
-            *ppNew = pNode;
-        }
         return pNode;
     }
 
@@ -373,6 +381,7 @@ protected:
 
 private:
     node_type *mpRoot;
+    node_allocator<node_type> mAllocator;
 };
 
 template<typename Key, typename Value>
@@ -404,6 +413,13 @@ public:
         print(out, this->root(), 0);
     }
 
+    /**
+     * Shape statistics with colors: 1 for red, 0 for black as tags
+     **/
+    shape_profile profile() {
+        return algs::tree::profile(this->root(), [](node_type *pNode) { return pNode->mRed ? 1 : 0; });
+    }
+
 private:
     void print(std::ostream& out, node_type *pNode, int depth) {
         if (pNode)
@@ -0,0 +1,145 @@
+#include <ostream>
+#include <utility>
+
+namespace helpers {
+
+/**
+ * Counts of basic operations performed on `counted` values
+ **/
+struct operation_counts {
+    size_t comparisons = 0;
+    size_t swaps = 0;
+    size_t moves = 0; // move constructions and assignments
+    size_t copies = 0; // copy constructions and assignments
+
+    operation_counts operator-(const operation_counts& other) const {
+        operation_counts result;
+        result.comparisons = comparisons - other.comparisons;
+        result.swaps = swaps - other.swaps;
+        result.moves = moves - other.moves;
+        result.copies = copies - other.copies;
+        return result;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const operation_counts& counts) {
+    return out << "comparisons: " << counts.comparisons
+        << ", swaps: " << counts.swaps
+        << ", moves: " << counts.moves
+        << ", copies: " << counts.copies;
+}
+
+/**
+ * Instrumented value type: behaves as a wrapped `T` for sorting purposes
+ * and counts comparisons, swaps, moves and copies in per-type counters.
+ * NOTE: Counters are shared by all counted<T> values and are not thread-safe
+ * NOTE: std::iter_swap finds `swap` by ADL, so a swap is counted once
+ *       instead of as three moves
+ **/
+template<typename T>
+class counted {
+public:
+    typedef T value_type;
+
+    counted()
+        : mValue()
+    {}
+
+    counted(T value)
+        : mValue(value)
+    {}
+
+    counted(const counted& other)
+        : mValue(other.mValue)
+    {
+        ++counts().copies;
+    }
+
+    counted(counted&& other)
+        : mValue(std::move(other.mValue))
+    {
+        ++counts().moves;
+    }
+
+    counted& operator=(const counted& other) {
+        ++counts().copies;
+        mValue = other.mValue;
+        return *this;
+    }
+
+    counted& operator=(counted&& other) {
+        ++counts().moves;
+        mValue = std::move(other.mValue);
+        return *this;
+    }
+
+    const T& value() const {
+        return mValue;
+    }
+
+    /**
+     * Counters for all counted<T> values
+     **/
+    static operation_counts& counts() {
+        static operation_counts instance;
+        return instance;
+    }
+
+    static void reset() {
+        counts() = operation_counts();
+    }
+
+    friend void swap(counted& lhs, counted& rhs) {
+        ++counts().swaps;
+        using std::swap;
+        swap(lhs.mValue, rhs.mValue);
+    }
+
+    friend bool operator<(const counted& lhs, const counted& rhs) {
+        ++counts().comparisons;
+        return lhs.mValue < rhs.mValue;
+    }
+
+    friend bool operator<=(const counted& lhs, const counted& rhs) {
+        ++counts().comparisons;
+        return lhs.mValue <= rhs.mValue;
+    }
+
+    friend bool operator>(const counted& lhs, const counted& rhs) {
+        ++counts().comparisons;
+        return lhs.mValue > rhs.mValue;
+    }
+
+    friend bool operator>=(const counted& lhs, const counted& rhs) {
+        ++counts().comparisons;
+        return lhs.mValue >= rhs.mValue;
+    }
+
+    // NOTE: equality is not counted, it is used by tests to check results
+    friend bool operator==(const counted& lhs, const counted& rhs) {
+        return lhs.mValue == rhs.mValue;
+    }
+
+    friend bool operator!=(const counted& lhs, const counted& rhs) {
+        return lhs.mValue != rhs.mValue;
+    }
+
+    friend std::ostream& operator<<(std::ostream& out, const counted& value) {
+        return out << value.mValue;
+    }
+
+private:
+    T mValue;
+};
+
+/**
+ * Count operations performed on counted<T> values during a call of `fn`
+ **/
+template<typename T, typename Fn>
+operation_counts count_operations(Fn fn) {
+    auto before = counted<T>::counts();
+    fn();
+    return counted<T>::counts() - before;
+}
+
+} // namespace helpers
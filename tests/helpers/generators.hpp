@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+namespace helpers {
+
+/**
+ * Uniformly distributed value: full range for integral types,
+ * [-1e9, 1e9) for floating point types
+ **/
+template<typename T>
+T random_value(std::mt19937& gen) {
+    if constexpr(std::is_integral_v<T>)
+        return std::uniform_int_distribution<T>(
+            std::numeric_limits<T>::lowest(), std::numeric_limits<T>::max())(gen);
+    else
+        return T(std::uniform_real_distribution<double>(-1e9, 1e9)(gen));
+}
+
+template<typename Iter>
+void fill_random(Iter begin, Iter end, std::mt19937& gen) {
+    using value_type = typename std::iterator_traits<Iter>::value_type;
+    for (auto it = begin; it != end; ++it)
+        *it = random_value<value_type>(gen);
+}
+
+template<typename Iter>
+void fill_sorted(Iter begin, Iter end, std::mt19937& gen) {
+    fill_random(begin, end, gen);
+    std::sort(begin, end);
+}
+
+template<typename Iter>
+void fill_reverse(Iter begin, Iter end, std::mt19937& gen) {
+    fill_sorted(begin, end, gen);
+    std::reverse(begin, end);
+}
+
+template<typename Iter>
+void fill_equal(Iter begin, Iter end, std::mt19937& gen) {
+    using value_type = typename std::iterator_traits<Iter>::value_type;
+    std::fill(begin, end, random_value<value_type>(gen));
+}
+
+// ascending first half, descending second half: 0 1 2 .. n/2 .. 2 1 0
+template<typename Iter>
+void fill_organ_pipe(Iter begin, Iter end, std::mt19937&) {
+    using value_type = typename std::iterator_traits<Iter>::value_type;
+    size_t n = size_t(std::distance(begin, end)), i = 0;
+    for (auto it = begin; it != end; ++it, ++i)
+        *it = value_type(i < n / 2 ? i : n - i - 1);
+}
+
+template<typename Iter>
+void fill_few_unique(Iter begin, Iter end, std::mt19937& gen) {
+    using value_type = typename std::iterator_traits<Iter>::value_type;
+    std::uniform_int_distribution<int> dis(0, 15);
+    for (auto it = begin; it != end; ++it)
+        *it = value_type(dis(gen));
+}
+
+// sqrt(n) ascending runs of length sqrt(n): 0 1 .. k 0 1 .. k ...
+template<typename Iter>
+void fill_sawtooth(Iter begin, Iter end, std::mt19937&) {
+    using value_type = typename std::iterator_traits<Iter>::value_type;
+    size_t n = size_t(std::distance(begin, end)), i = 0;
+    size_t period = std::max<size_t>(2, size_t(std::sqrt(double(n))));
+    for (auto it = begin; it != end; ++it, ++i)
+        *it = value_type(i % period);
+}
+
+/**
+ * A named input shape
+ **/
+template<typename Iter>
+struct input {
+    const char *name;
+    void (*fill)(Iter, Iter, std::mt19937&);
+    bool adversarial; // degrades naive quicksorts
+};
+
+template<typename Iter>
+std::vector<input<Iter>> inputs() {
+    return {
+        { "random", fill_random<Iter>, false },
+        { "sorted", fill_sorted<Iter>, true },
+        { "reverse", fill_reverse<Iter>, true },
+        { "equal", fill_equal<Iter>, true },
+        { "organ_pipe", fill_organ_pipe<Iter>, true },
+        { "few_unique", fill_few_unique<Iter>, true },
+        { "sawtooth", fill_sawtooth<Iter>, true },
+    };
+}
+
+/**
+ * McIlroy's adversary for quicksorts ("A Killer Adversary for Quicksort",
+ * 1999). Values of `item`s are "gas", greater than any solid value, until
+ * a comparison of two gas items freezes one of them to the next solid
+ * value: the one which is not a pivot candidate. So a pivot is always
+ * compared as greater than everything frozen so far and partitions stay
+ * lopsided. Replaying frozen values on a deterministic sort forces it
+ * to perform the same comparisons
+ **/
+class antiqsort {
+public:
+    class item {
+    public:
+        item()
+            : mpAdversary(nullptr), mIndex(0)
+        {}
+
+        item(antiqsort *pAdversary, size_t index)
+            : mpAdversary(pAdversary), mIndex(index)
+        {}
+
+        friend bool operator<(const item& lhs, const item& rhs) {
+            return lhs.compare(rhs) < 0;
+        }
+
+        friend bool operator<=(const item& lhs, const item& rhs) {
+            return lhs.compare(rhs) <= 0;
+        }
+
+        friend bool operator>(const item& lhs, const item& rhs) {
+            return lhs.compare(rhs) > 0;
+        }
+
+        friend bool operator>=(const item& lhs, const item& rhs) {
+            return lhs.compare(rhs) >= 0;
+        }
+
+        friend bool operator==(const item& lhs, const item& rhs) {
+            return lhs.compare(rhs) == 0;
+        }
+
+        friend bool operator!=(const item& lhs, const item& rhs) {
+            return lhs.compare(rhs) != 0;
+        }
+
+    private:
+        int compare(const item& other) const {
+            return mpAdversary->compare(mIndex, other.mIndex);
+        }
+
+        antiqsort *mpAdversary;
+        size_t mIndex;
+    };
+
+    explicit antiqsort(size_t n)
+        : mValues(n, n), mGas(n), mSolid(0), mCandidate(0), mComparisons(0)
+    {}
+
+    antiqsort(const antiqsort&) = delete;
+    antiqsort& operator=(const antiqsort&) = delete;
+
+    /**
+     * Items to sort, i-th item stands for i-th input position
+     **/
+    std::vector<item> items() {
+        std::vector<item> result;
+        for (size_t i = 0; i < mValues.size(); ++i)
+            result.emplace_back(this, i);
+        return result;
+    }
+
+    /**
+     * Input forcing the comparisons made so far: a permutation of 0..n-1.
+     * Items never compared are frozen in input order
+     **/
+    template<typename T>
+    std::vector<T> values() {
+        std::vector<T> result;
+        for (auto& value : mValues) {
+            if (value == mGas)
+                value = mSolid++;
+            result.push_back(T(value));
+        }
+        return result;
+    }
+
+    size_t comparisons() const {
+        return mComparisons;
+    }
+
+private:
+    int compare(size_t x, size_t y) {
+        ++mComparisons;
+        if (mValues[x] == mGas && mValues[y] == mGas)
+            mValues[x == mCandidate ? y : x] = mSolid++;
+        if (mValues[x] == mGas)
+            mCandidate = x;
+        else if (mValues[y] == mGas)
+            mCandidate = y;
+        return mValues[x] < mValues[y] ? -1 : mValues[y] < mValues[x] ? 1 : 0;
+    }
+
+    std::vector<size_t> mValues;
+    size_t mGas, mSolid, mCandidate, mComparisons;
+};
+
+/**
+ * Adversarial input of size `n` for a deterministic `sort`
+ * called as sort(begin, end) on antiqsort::item iterators
+ **/
+template<typename T, typename SortFn>
+std::vector<T> antiqsort_input(size_t n, SortFn sort) {
+    antiqsort adversary(n);
+    auto items = adversary.items();
+    sort(items.begin(), items.end());
+    return adversary.values<T>();
+}
+
+} // namespace helpers
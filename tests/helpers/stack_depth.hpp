@@ -0,0 +1,100 @@
+#include <cstdint>
+#include <ostream>
+
+namespace helpers {
+
+/**
+ * Peak stack usage of a call, sampled whenever two `probed` values are
+ * compared. A sort recursing d levels deep uses about d stack frames,
+ * so the result grows linearly with its recursion depth.
+ * NOTE: Assumes a downward growing stack, not thread-safe
+ **/
+class stack_depth {
+public:
+    /**
+     * Stack bytes used below the caller's frame during a call of `fn`
+     **/
+    template<typename Fn>
+    static size_t measure(Fn fn) {
+        char marker;
+        base() = lowest() = reinterpret_cast<uintptr_t>(&marker);
+        fn();
+        return size_t(base() - lowest());
+    }
+
+    static void sample() {
+        char marker;
+        auto address = reinterpret_cast<uintptr_t>(&marker);
+        if (address < lowest())
+            lowest() = address;
+    }
+
+private:
+    static uintptr_t& base() {
+        static uintptr_t instance = 0;
+        return instance;
+    }
+
+    static uintptr_t& lowest() {
+        static uintptr_t instance = 0;
+        return instance;
+    }
+};
+
+/**
+ * Value type sampling stack usage on every comparison
+ **/
+template<typename T>
+class probed {
+public:
+    typedef T value_type;
+
+    probed()
+        : mValue()
+    {}
+
+    probed(T value)
+        : mValue(value)
+    {}
+
+    const T& value() const {
+        return mValue;
+    }
+
+    friend bool operator<(const probed& lhs, const probed& rhs) {
+        stack_depth::sample();
+        return lhs.mValue < rhs.mValue;
+    }
+
+    friend bool operator<=(const probed& lhs, const probed& rhs) {
+        stack_depth::sample();
+        return lhs.mValue <= rhs.mValue;
+    }
+
+    friend bool operator>(const probed& lhs, const probed& rhs) {
+        stack_depth::sample();
+        return lhs.mValue > rhs.mValue;
+    }
+
+    friend bool operator>=(const probed& lhs, const probed& rhs) {
+        stack_depth::sample();
+        return lhs.mValue >= rhs.mValue;
+    }
+
+    friend bool operator==(const probed& lhs, const probed& rhs) {
+        return lhs.mValue == rhs.mValue;
+    }
+
+    friend bool operator!=(const probed& lhs, const probed& rhs) {
+        return lhs.mValue != rhs.mValue;
+    }
+
+    friend std::ostream& operator<<(std::ostream& out, const probed& value) {
+        return out << value.mValue;
+    }
+
+private:
+    T mValue;
+};
+
+} // namespace helpers
@@ -5,6 +5,9 @@
 #include <deque>
 #include <random>
 
+#include "helpers/counted.hpp"
+#include "helpers/generators.hpp"
+
 template<typename T>
 std::ostream& operator<<(std::ostream& out, const std::vector<T> v) {
     for (const auto& it : v)
@@ -50,6 +53,20 @@ fill_container(ForwardIterator begin,
     std::generate(begin, end, fn);
 }
 
+/**
+ * Fill a container with a named input shape, see helpers::inputs
+ **/
+template<typename ForwardIterator>
+void
+fill_container(ForwardIterator begin,
+               ForwardIterator end,
+               const helpers::input<ForwardIterator>& input)
+{
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    input.fill(begin, end, gen);
+}
+
 template<typename Iter1,
          typename Iter2>
 void test_sort_on_container(
@@ -108,6 +125,78 @@ void test_sort(ContainerSortFn<Container> sortFn)
     }
 }
 
+/**
+ * Sort a container of helpers::counted values and check the result.
+ * Operation counts are recorded as test properties (see --gtest_output=xml)
+ * and printed if COUNT_OPERATIONS is defined
+ **/
+template<typename Container>
+void test_sort_counted(ContainerSortFn<Container> sortFn)
+{
+    using counted_type = typename Container::value_type;
+    using value_type = typename counted_type::value_type;
+    std::vector<value_type> original(MAX_CONTAINER_SIZE);
+
+    for (const auto& sz : TEST_CONTAINER_SIZES) {
+        assert(sz <= MAX_CONTAINER_SIZE);
+        auto original_end = std::next(original.begin(), sz);
+        fill_container(original.begin(), original_end);
+        std::vector<value_type> reference(original.begin(), original_end);
+        std::sort(reference.begin(), reference.end());
+
+        Container cont(original.begin(), original_end);
+        auto counts = helpers::count_operations<value_type>(
+            [&] { sortFn(cont.begin(), cont.end()); });
+
+        auto suffix = "_" + std::to_string(sz);
+        ::testing::Test::RecordProperty("comparisons" + suffix, counts.comparisons);
+        ::testing::Test::RecordProperty("swaps" + suffix, counts.swaps);
+        ::testing::Test::RecordProperty("moves" + suffix, counts.moves);
+        ::testing::Test::RecordProperty("copies" + suffix, counts.copies);
+#ifdef COUNT_OPERATIONS
+        std::cout << "size: " << sz << ", " << counts << std::endl;
+#endif
+
+        ASSERT_TRUE(std::equal(cont.begin(), cont.end(), reference.begin(),
+            [](const counted_type& lhs, const value_type& rhs) { return lhs.value() == rhs; }));
+    }
+}
+
+using AdversarySortFn = ContainerSortFn<std::vector<helpers::antiqsort::item>>;
+
+/**
+ * Sort adversarial inputs: sorted, reverse, all-equal, organ-pipe,
+ * few-unique, sawtooth and antiqsort inputs built against `adversarySortFn`,
+ * the same sort instantiated for helpers::antiqsort::item
+ **/
+template<typename Container>
+void test_sort_adversarial(ContainerSortFn<Container> sortFn,
+                           AdversarySortFn adversarySortFn)
+{
+    using value_type = typename Container::value_type;
+    Container cont(MAX_CONTAINER_SIZE);
+    Container rcont(MAX_CONTAINER_SIZE);
+
+    for (const auto& input : helpers::inputs<typename Container::iterator>()) {
+        for (const auto& sz : TEST_CONTAINER_SIZES) {
+            assert(sz <= MAX_CONTAINER_SIZE);
+            auto cont_end = std::next(cont.begin(), sz);
+            fill_container(cont.begin(), cont_end, input);
+            auto rcont_end = std::copy(cont.begin(), cont_end, rcont.begin());
+            std::sort(rcont.begin(), rcont_end);
+            sortFn(cont.begin(), cont_end);
+            ASSERT_TRUE(std::equal(cont.begin(), cont_end, rcont.begin())) << input.name << ' ' << sz;
+        }
+    }
+
+    for (const auto& sz : TEST_CONTAINER_SIZES) {
+        auto values = helpers::antiqsort_input<value_type>(sz, adversarySortFn);
+        Container adversarial(values.begin(), values.end());
+        sortFn(adversarial.begin(), adversarial.end());
+        ASSERT_TRUE(std::is_sorted(adversarial.begin(), adversarial.end())) << "antiqsort " << sz;
+    }
+}
+
 // todo: fix test for std::list
 #define REGISTER_TESTS(SECTION, PREFIX, FN) \
     TEST(SECTION, PREFIX ## VectorInt) { \
@@ -115,5 +204,11 @@ void test_sort(ContainerSortFn<Container> sortFn)
     } \
     TEST(SECTION, PREFIX ## DequeInt) { \
         test_sort<std::deque<int>>(FN); \
+    } \
+    TEST(SECTION, PREFIX ## VectorCounted) { \
+        test_sort_counted<std::vector<helpers::counted<int>>>(FN); \
+    } \
+    TEST(SECTION, PREFIX ## VectorAdversarial) { \
+        test_sort_adversarial<std::vector<int>>(FN, FN); \
     }
  
@@ -1,6 +1,9 @@
 #include "common.hpp"
 #include "algs/sort/heap.hpp"
 
+#include <iterator>
+#include <sstream>
+
 namespace {
     TEST(Sort, Heap_IsMaxHeap) {
         std::vector<int> emptyHeap = {};
@@ -111,5 +114,107 @@ namespace {
     }
 
     REGISTER_TESTS(Sort, Heap_Sort, algs::sort::heap::sort)
-}
 
+    TEST(Sort, Heap_Sort_Observer) {
+        const size_t size = 1000;
+        std::vector<int> v(size);
+        fill_container(v.begin(), v.end());
+        algs::sort::trace_observer trace;
+        algs::sort::heap::sort(v.begin(), v.end(), trace);
+        ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+
+        // size/2 sifts to make a heap, then one per extracted element
+        ASSERT_EQ(trace.events().size(), size / 2 + size);
+        for (const auto& e : trace.events()) {
+            ASSERT_EQ(e.kind, algs::sort::trace_observer::SIFT);
+            ASSERT_LE(e.first, 9u); // heap of 1000 elements is 10 levels high
+        }
+    }
+
+    TEST(Sort, Heap_SortHeap) {
+        std::vector<int> v(1000);
+        fill_container(v.begin(), v.end());
+        algs::sort::heap::make_heap(v.begin(), v.end());
+        algs::sort::heap::sort_heap(v.begin(), v.end());
+        ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+    }
+
+    TEST(Sort, Heap_PartialSort) {
+        using Iter = std::vector<int>::iterator;
+        for (const auto& input : helpers::inputs<Iter>()) {
+            for (size_t size : { 0, 1, 2, 17, 1000 }) {
+                for (size_t k : { std::min<size_t>(1, size), size / 3, size }) {
+                    std::vector<int> v(size);
+                    fill_container(v.begin(), v.end(), input);
+                    auto reference = v;
+                    std::sort(reference.begin(), reference.end());
+                    auto original = v;
+                    auto middle = std::next(v.begin(), k);
+                    algs::sort::heap::partial_sort(v.begin(), middle, v.end());
+                    ASSERT_TRUE(std::equal(v.begin(), middle, reference.begin())) << input.name;
+                    // the rest is a permutation of the other elements
+                    std::sort(middle, v.end());
+                    ASSERT_TRUE(std::equal(v.begin(), v.end(), reference.begin())) << input.name;
+                    ASSERT_TRUE(std::is_permutation(v.begin(), v.end(), original.begin())) << input.name;
+                }
+            }
+        }
+    }
+
+    TEST(Sort, Heap_PartialSort_Observer) {
+        const size_t size = 10000, k = 10;
+        std::vector<int> v(size);
+        fill_container(v.begin(), v.end());
+        algs::sort::trace_observer trace;
+        algs::sort::heap::partial_sort(v.begin(), std::next(v.begin(), k), v.end(), trace);
+        ASSERT_TRUE(std::is_sorted(v.begin(), std::next(v.begin(), k)));
+        // sifts stay within the heap of k elements, 4 levels high
+        ASSERT_LE(trace.events().size(), k / 2 + (size - k) + k);
+        for (const auto& e : trace.events())
+            ASSERT_LE(e.first, 3u);
+    }
+
+    TEST(Sort, Heap_PartialSortCopy) {
+        std::vector<int> original(1000);
+        fill_container(original.begin(), original.end(), -100, 100);
+        auto reference = original;
+        std::sort(reference.begin(), reference.end());
+        std::ostringstream text;
+        for (int x : original)
+            text << x << ' ';
+        for (size_t k : { 0, 1, 10, 1000, 2000 }) {
+            // input iterators are read once
+            std::istringstream in(text.str());
+            std::vector<int> result(k);
+            auto last = algs::sort::heap::partial_sort_copy(
+                std::istream_iterator<int>(in), std::istream_iterator<int>(), result.begin(), result.end());
+            size_t count = std::min(k, original.size());
+            ASSERT_EQ(last, std::next(result.begin(), count));
+            ASSERT_TRUE(std::equal(result.begin(), last, reference.begin()));
+        }
+    }
+
+    TEST(Sort, Heap_TopK) {
+        std::vector<int> original(1000);
+        fill_container(original.begin(), original.end(), -100, 100);
+        auto reference = original;
+        std::sort(reference.begin(), reference.end());
+        for (size_t k : { 0, 1, 10, 1000, 2000 }) {
+            std::list<int> stream(original.begin(), original.end());
+            auto result = algs::sort::heap::top_k(stream.begin(), stream.end(), k);
+            ASSERT_EQ(result.size(), std::min(k, original.size()));
+            ASSERT_TRUE(std::equal(result.begin(), result.end(), reference.begin()));
+        }
+    }
+
+    TEST(Sort, Heap_TopK_Comparisons) {
+        const size_t size = 100000, k = 16;
+        std::vector<int> original(size);
+        fill_container(original.begin(), original.end());
+        std::vector<helpers::counted<int>> v(original.begin(), original.end());
+        auto counts = helpers::count_operations<int>(
+            [&] { algs::sort::heap::top_k(v.begin(), v.end(), k); });
+        // a comparison per element and rare sifts of log2(k) levels
+        ASSERT_LE(counts.comparisons, 2 * size);
+    }
+}
@@ -1,11 +1,49 @@
 #include "common.hpp"
 #include "algs/sort/merge.hpp"
 
+#include <string>
+
 namespace {
     REGISTER_TESTS(Sort, Merge_SortRecursive, algs::sort::merge::sort_recursive)
     REGISTER_TESTS(Sort, Merge_SortRecursiveInplace, algs::sort::merge::sort_recursive_inplace)
     REGISTER_TESTS(Sort, Merge_SortBottomup, algs::sort::merge::sort_bottomup)
     REGISTER_TESTS(Sort, Merge_SortBottomupInplace, algs::sort::merge::sort_bottomup_inplace)
+    REGISTER_TESTS(Sort, Merge_SortRecursivePingpong, algs::sort::merge::sort_recursive_pingpong)
+    REGISTER_TESTS(Sort, Merge_SortBottomupPingpong, algs::sort::merge::sort_bottomup_pingpong)
+    REGISTER_TESTS(Sort, Merge_SortNatural, algs::sort::merge::sort_natural)
+    REGISTER_TESTS(Sort, Merge_SortBlockMerge, algs::sort::merge::sort_block_merge)
+
+    // compared by key only, to check stability
+    struct keyed {
+        int key;
+        size_t index;
+
+        bool operator<(const keyed& other) const {
+            return key < other.key;
+        }
+    };
+
+    /**
+     * Sort (key, index) pairs with few distinct keys in shapes of `inputs`
+     * and check that indices of equal keys stay ascending
+     **/
+    void test_sort_stable(void (*sortFn)(std::vector<keyed>::iterator, std::vector<keyed>::iterator)) {
+        using Iter = std::vector<int>::iterator;
+        for (const auto& input : helpers::inputs<Iter>()) {
+            for (size_t size : { 1, 7, 100, 1000, 10000 }) {
+                std::vector<int> keys(size);
+                fill_container(keys.begin(), keys.end(), input);
+                std::vector<keyed> v(size);
+                for (size_t i = 0; i < size; ++i)
+                    v[i] = { keys[i] % 16, i };
+                sortFn(v.begin(), v.end());
+                ASSERT_TRUE(std::is_sorted(v.begin(), v.end())) << input.name;
+                ASSERT_TRUE(std::adjacent_find(v.begin(), v.end(), [](const keyed& lhs, const keyed& rhs) {
+                    return lhs.key == rhs.key && lhs.index > rhs.index;
+                }) == v.end()) << input.name << ' ' << size;
+            }
+        }
+    }
 
     TEST(Sort, Merge_Merge) {
         using Container = std::vector<int>;
@@ -67,6 +105,29 @@ namespace {
         }
     }
 
+    TEST(Sort, Merge_MergeTmp_Counted) {
+        using Container = std::vector<helpers::counted<int>>;
+        for (const auto size : TEST_CONTAINER_SIZES) {
+            // two sorted halves: 0 2 4 ... and 1 3 5 ...
+            Container cont;
+            for (size_t i = 0; i < size; i += 2)
+                cont.push_back(int(i));
+            auto mid = cont.size();
+            for (size_t i = 1; i < size; i += 2)
+                cont.push_back(int(i));
+            Container tmp(size);
+
+            auto counts = helpers::count_operations<int>([&] {
+                algs::sort::merge::merge_tmp(cont.begin(), std::next(cont.begin(), mid), cont.end(), tmp.begin());
+            });
+
+            // both halves are copied to tmp and then back
+            ASSERT_EQ(counts.copies, 2 * size);
+            ASSERT_EQ(counts.moves, 0u);
+            ASSERT_EQ(counts.swaps, 0u);
+        }
+    }
+
     TEST(Sort, Merge_InplaceMerge) {
         using Container = std::vector<int>;
         using value_type = Container::value_type;
@@ -96,5 +157,266 @@ namespace {
             }
         }
     }
-}
 
+    TEST(Sort, Merge_SortRecursive_Observer) {
+        const size_t size = 1024;
+        std::vector<int> v(size);
+        fill_container(v.begin(), v.end());
+        algs::sort::trace_observer trace;
+        algs::sort::merge::sort_recursive(v.begin(), v.end(), trace);
+        ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+
+        // a merge per internal node of a balanced recursion tree
+        ASSERT_EQ(trace.events().size(), size - 1);
+        ASSERT_EQ(trace.max_depth(), 10u);
+        const auto& last = trace.events().back();
+        ASSERT_EQ(last.kind, algs::sort::trace_observer::MERGE);
+        ASSERT_EQ(last.depth, 1u);
+        ASSERT_EQ(last.first, size / 2);
+        ASSERT_EQ(last.second, size / 2);
+    }
+
+    TEST(Sort, Merge_SortBottomup_Observer) {
+        const size_t size = 1000;
+        std::vector<int> v(size);
+        fill_container(v.begin(), v.end());
+        algs::sort::trace_observer trace;
+        algs::sort::merge::sort_bottomup(v.begin(), v.end(), trace);
+        ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+
+        size_t merged = 0;
+        for (const auto& e : trace.events()) {
+            ASSERT_EQ(e.kind, algs::sort::trace_observer::MERGE);
+            ASSERT_GT(e.second, 0u);
+            ASSERT_LE(e.second, e.first);
+            merged += e.first + e.second;
+        }
+        // each of ceil(log2(size)) passes merges every element at most once
+        ASSERT_LE(merged, size * 10);
+        ASSERT_EQ(trace.events().back().first + trace.events().back().second, size);
+    }
+
+    TEST(Sort, Merge_GallopSearch) {
+        auto less = [](int lhs, int rhs) { return lhs < rhs; };
+        std::vector<int> v = { 0, 1, 1, 2, 2, 2, 3, 5, 5, 8, 9, 9, 9, 9, 9, 9, 9, 12, 20 };
+        for (int key = -1; key <= 21; ++key) {
+            ASSERT_EQ(algs::sort::merge::gallop_upper(key, v.begin(), v.end(), less),
+                std::upper_bound(v.begin(), v.end(), key));
+            ASSERT_EQ(algs::sort::merge::gallop_lower(key, v.begin(), v.end(), less),
+                std::lower_bound(v.begin(), v.end(), key));
+        }
+    }
+
+    TEST(Sort, Merge_NaturalRun) {
+        std::vector<int> v = { 1, 2, 2, 3, 1, 5, 4, 4, 3 };
+        auto run = algs::sort::merge::natural_run(v.begin(), v.end());
+        ASSERT_EQ(std::distance(v.begin(), run), 4);
+        // strictly descending run is reversed, equal elements end it
+        std::vector<int> w = { 5, 4, 3, 3, 1 };
+        run = algs::sort::merge::natural_run(w.begin(), w.end());
+        ASSERT_EQ(std::distance(w.begin(), run), 3);
+        ASSERT_EQ(w, std::vector<int>({ 3, 4, 5, 3, 1 }));
+    }
+
+    TEST(Sort, Merge_SortNatural_Stable) {
+        test_sort_stable(algs::sort::merge::sort_natural);
+    }
+
+    TEST(Sort, Merge_SortNatural_Presorted) {
+        const size_t size = 100000;
+        std::vector<int> original(size);
+        fill_container(original.begin(), original.end());
+        // concatenated sorted batches
+        const size_t batches = 8;
+        for (size_t i = 0; i < batches; ++i)
+            std::sort(std::next(original.begin(), size * i / batches), std::next(original.begin(), size * (i + 1) / batches));
+        auto reference = original;
+        std::sort(reference.begin(), reference.end());
+
+        std::vector<helpers::counted<int>> v(original.begin(), original.end());
+        auto counts = helpers::count_operations<int>(
+            [&] { algs::sort::merge::sort_natural(v.begin(), v.end()); });
+        ASSERT_TRUE(std::equal(v.begin(), v.end(), reference.begin(),
+            [](const helpers::counted<int>& lhs, int rhs) { return lhs.value() == rhs; }));
+        // a pass to find runs and log2(batches) merge passes
+        ASSERT_LE(counts.comparisons, size * 5);
+
+        // sorted and strictly descending inputs are a single run
+        for (bool descending : { false, true }) {
+            std::vector<helpers::counted<int>> w(reference.begin(), reference.end());
+            w.erase(std::unique(w.begin(), w.end(),
+                [](const auto& lhs, const auto& rhs) { return lhs.value() == rhs.value(); }), w.end());
+            if (descending)
+                std::reverse(w.begin(), w.end());
+            algs::sort::trace_observer trace;
+            counts = helpers::count_operations<int>(
+                [&] { algs::sort::merge::sort_natural(w.begin(), w.end(), trace); });
+            ASSERT_TRUE(std::is_sorted(w.begin(), w.end()));
+            ASSERT_EQ(counts.comparisons, w.size() - 1);
+            ASSERT_TRUE(trace.events().empty());
+        }
+    }
+
+    TEST(Sort, Merge_SortNatural_Observer) {
+        const size_t size = 100000;
+        std::vector<int> v(size);
+        fill_container(v.begin(), v.end());
+        algs::sort::trace_observer trace;
+        algs::sort::merge::sort_natural(v.begin(), v.end(), trace);
+        ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+
+        // random input: runs of natural_min_run elements merged as a balanced tree
+        size_t min_run = algs::sort::merge::natural_min_run(size);
+        ASSERT_GE(min_run, 32u);
+        ASSERT_LE(min_run, 64u);
+        ASSERT_EQ(trace.events().size(), (size + min_run - 1) / min_run - 1);
+        size_t merged = 0;
+        for (const auto& e : trace.events())
+            merged += e.first + e.second;
+        ASSERT_LE(merged, size * size_t(std::log2(size / min_run) + 2));
+        ASSERT_EQ(trace.events().back().first + trace.events().back().second, size);
+    }
+
+    TEST(Sort, Merge_MergeBlocks) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        for (size_t size : { 2, 10, 100, 1000, 5000 }) {
+            for (size_t block : { 1, 3, 8, 40 }) {
+                for (int i = 0; i < 20; ++i) {
+                    // few keys, so that equal elements are in both runs
+                    std::vector<keyed> v(size);
+                    for (size_t j = 0; j < size; ++j)
+                        v[j] = { std::uniform_int_distribution<int>(0, 9)(gen), j };
+                    auto mid = std::next(v.begin(), std::uniform_int_distribution<size_t>(0, size)(gen));
+                    std::stable_sort(v.begin(), mid);
+                    std::stable_sort(mid, v.end());
+                    auto reference = v;
+                    std::stable_sort(reference.begin(), reference.end());
+
+                    std::vector<keyed> buffer(block);
+                    std::vector<size_t> tags(size / block + 1);
+                    size_t min_gallop = 7;
+                    algs::sort::merge::merge_blocks(v.begin(), mid, v.end(), buffer.begin(), block, tags, min_gallop);
+                    ASSERT_TRUE(std::equal(v.begin(), v.end(), reference.begin(), [](const keyed& lhs, const keyed& rhs) {
+                        return lhs.key == rhs.key && lhs.index == rhs.index;
+                    })) << "size " << size << ", block " << block;
+                }
+            }
+        }
+    }
+
+    TEST(Sort, Merge_SortBlockMerge_Stable) {
+        test_sort_stable(algs::sort::merge::sort_block_merge);
+    }
+
+    TEST(Sort, Merge_SortBlockMerge_Counted) {
+        const size_t size = 100000;
+        std::vector<int> original(size);
+        fill_container(original.begin(), original.end());
+        std::vector<helpers::counted<int>> v(original.begin(), original.end());
+        auto counts = helpers::count_operations<int>(
+            [&] { algs::sort::merge::sort_block_merge(v.begin(), v.end()); });
+        ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+        // O(n log n) unlike sort_bottomup_inplace
+        size_t log = size_t(std::log2(size)) + 1;
+        ASSERT_LE(counts.comparisons, 3 * size * log);
+        ASSERT_LE(counts.moves + 3 * counts.swaps, 8 * size * log);
+    }
+
+    TEST(Sort, Merge_SortPingpong_Stable) {
+        test_sort_stable(algs::sort::merge::sort_recursive_pingpong);
+        test_sort_stable(algs::sort::merge::sort_bottomup_pingpong);
+    }
+
+    TEST(Sort, Merge_SortPingpong_Counted) {
+        using Container = std::vector<helpers::counted<int>>;
+        for (size_t size : { 1000, 1024, 1025 }) {
+            std::vector<int> original(size);
+            fill_container(original.begin(), original.end());
+            size_t levels = size_t(std::ceil(std::log2(size)));
+            {
+                Container v(original.begin(), original.end());
+                auto counts = helpers::count_operations<int>(
+                    [&] { algs::sort::merge::sort_bottomup_pingpong(v.begin(), v.end()); });
+                ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+                // a move per element and pass, and a pass back if the number of passes is odd
+                ASSERT_EQ(counts.copies, 0u);
+                ASSERT_EQ(counts.moves, size * (levels + levels % 2));
+            }
+            {
+                Container v(original.begin(), original.end());
+                auto counts = helpers::count_operations<int>(
+                    [&] { algs::sort::merge::sort_recursive_pingpong(v.begin(), v.end()); });
+                ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+                // a move per element and level, and a move of leaves of odd depth
+                ASSERT_EQ(counts.copies, 0u);
+                ASSERT_LE(counts.moves, size * (levels + 1));
+            }
+            {
+                Container v(original.begin(), original.end());
+                auto counts = helpers::count_operations<int>(
+                    [&] { algs::sort::merge::sort_bottomup(v.begin(), v.end()); });
+                // merge_tmp copies every element twice per pass, except unpaired tails
+                ASSERT_LE(counts.copies, 2 * size * levels);
+                ASSERT_GT(counts.copies, 2 * size * (levels - 1));
+            }
+        }
+    }
+
+    TEST(Sort, Merge_SortRecursivePingpong_Observer) {
+        const size_t size = 1024;
+        std::vector<int> v(size);
+        fill_container(v.begin(), v.end());
+        algs::sort::trace_observer trace;
+        algs::sort::merge::sort_recursive_pingpong(v.begin(), v.end(), trace);
+        ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+        ASSERT_EQ(trace.events().size(), size - 1);
+        ASSERT_EQ(trace.max_depth(), 10u);
+    }
+
+    TEST(Sort, Merge_Sort_Scratch) {
+        using Fn = void (*)(std::vector<int>::iterator, std::vector<int>::iterator, algs::sort::scratch_buffer<int>&);
+        std::vector<std::pair<const char *, Fn>> sorts = {
+            { "sort_recursive", algs::sort::merge::sort_recursive },
+            { "sort_bottomup", algs::sort::merge::sort_bottomup },
+            { "sort_recursive_pingpong", algs::sort::merge::sort_recursive_pingpong },
+            { "sort_bottomup_pingpong", algs::sort::merge::sort_bottomup_pingpong },
+        };
+        for (bool huge_pages : { false, true }) {
+            for (const auto& sort : sorts) {
+                // one buffer for many sorts of different sizes
+                algs::sort::scratch_buffer<int> scratch(huge_pages);
+                // 2MB of ints is large enough for huge pages
+                size_t large = huge_pages ? 1 << 19 : 1 << 12;
+                for (size_t size : { size_t(1000), size_t(10), size_t(0), large, size_t(1000) }) {
+                    std::vector<int> v(size);
+                    fill_container(v.begin(), v.end());
+                    auto reference = v;
+                    std::sort(reference.begin(), reference.end());
+                    sort.second(v.begin(), v.end(), scratch);
+                    ASSERT_EQ(v, reference) << sort.first;
+                }
+                ASSERT_GE(scratch.capacity(), large);
+#ifdef __linux__
+                ASSERT_EQ(scratch.huge_pages(), huge_pages);
+#endif
+            }
+        }
+    }
+
+    TEST(Sort, Merge_Sort_Scratch_NonTrivial) {
+        algs::sort::scratch_buffer<std::string> scratch;
+        for (size_t size : { 100, 1000 }) {
+            std::vector<std::string> v(size);
+            for (auto& s : v)
+                s = std::to_string(std::rand());
+            auto reference = v;
+            std::sort(reference.begin(), reference.end());
+            auto w = v;
+            algs::sort::merge::sort_bottomup(v.begin(), v.end(), scratch);
+            ASSERT_EQ(v, reference);
+            algs::sort::merge::sort_bottomup_pingpong(w.begin(), w.end(), scratch);
+            ASSERT_EQ(w, reference);
+        }
+    }
+}
@@ -0,0 +1,204 @@
+#include "common.hpp"
+#include "algs/sort/parallel.hpp"
+
+#include <functional>
+#include <iterator>
+#include <numeric>
+
+namespace {
+    TEST(Sort, Parallel_ForEachChunk) {
+        std::vector<int> v(1000, 0);
+        for (size_t threads : { 1, 2, 3, 7 }) {
+            std::vector<size_t> sizes(threads, 0);
+            algs::sort::parallel::for_each_chunk(v.begin(), v.end(), threads,
+                [&](size_t index, std::vector<int>::iterator first, std::vector<int>::iterator last) {
+                    sizes[index] = size_t(std::distance(first, last));
+                    for (; first != last; ++first)
+                        ++*first;
+                });
+            ASSERT_EQ(std::accumulate(sizes.begin(), sizes.end(), size_t(0)), v.size());
+            ASSERT_LE(*std::max_element(sizes.begin(), sizes.end()) - *std::min_element(sizes.begin(), sizes.end()), 1u);
+        }
+        ASSERT_TRUE(std::all_of(v.begin(), v.end(), [](int x) { return x == 4; }));
+    }
+
+    TEST(Sort, Parallel_Select) {
+        using Iter = std::vector<int>::iterator;
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        for (const auto& input : helpers::inputs<Iter>()) {
+            // large enough for a counting round
+            for (size_t size : { size_t(1), size_t(1000), size_t(1) << 18 }) {
+                std::vector<int> v(size);
+                fill_container(v.begin(), v.end(), input);
+                auto original = v;
+                auto reference = v;
+                std::sort(reference.begin(), reference.end());
+                for (size_t threads : { 1, 4 }) {
+                    for (size_t k : { size_t(0), size / 2, size * 99 / 100, size - 1,
+                                      std::uniform_int_distribution<size_t>(0, size - 1)(gen) }) {
+                        ASSERT_EQ(algs::sort::parallel::select(v.begin(), v.end(), k, threads), reference[k])
+                            << input.name << ", size " << size << ", k " << k;
+                    }
+                }
+                ASSERT_EQ(v, original);
+            }
+        }
+    }
+
+    TEST(Sort, Parallel_Select_Double) {
+        const size_t size = 1 << 18;
+        std::vector<double> v(size);
+        fill_container(v.begin(), v.end(), -1., 1.);
+        auto reference = v;
+        std::sort(reference.begin(), reference.end());
+        for (size_t k : { size_t(0), size / 2, size - 1 })
+            ASSERT_EQ(algs::sort::parallel::select(v.begin(), v.end(), k, 3), reference[k]);
+    }
+
+    TEST(Sort, Parallel_PartitionIf) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        // large enough for several blocks with a cleanup phase
+        for (size_t size : { size_t(0), size_t(1), size_t(1000), size_t(1) << 18 }) {
+            std::vector<int> original(size);
+            fill_container(original.begin(), original.end(), -1000, 1000);
+            auto reference = original;
+            std::sort(reference.begin(), reference.end());
+            for (size_t threads : { 1, 3, 4 }) {
+                // mostly true, mostly false, balanced and unbalanced between blocks
+                int threshold = std::uniform_int_distribution<int>(-1000, 1000)(gen);
+                std::vector<std::function<bool(int)>> predicates = {
+                    [](int x) { return x % 2 == 0; },
+                    [](int x) { return x < -900; },
+                    [](int x) { return x > -900; },
+                    [=](int x) { return x < threshold; },
+                };
+                for (const auto& predicate : predicates) {
+                    auto v = original;
+                    auto split = algs::sort::parallel::partition_if(v.begin(), v.end(), predicate, threads);
+                    ASSERT_TRUE(std::all_of(v.begin(), split, predicate));
+                    ASSERT_TRUE(std::none_of(split, v.end(), predicate));
+                    ASSERT_EQ(std::distance(v.begin(), split), std::count_if(original.begin(), original.end(), predicate));
+                    std::sort(v.begin(), v.end());
+                    ASSERT_EQ(v, reference);
+                }
+            }
+        }
+    }
+
+    TEST(Sort, Parallel_Partition) {
+        using Iter = std::vector<int>::iterator;
+        for (const auto& input : helpers::inputs<Iter>()) {
+            for (size_t size : { size_t(1), size_t(1000), size_t(1) << 18 }) {
+                std::vector<int> original(size);
+                fill_container(original.begin(), original.end(), input);
+                auto reference = original;
+                std::sort(reference.begin(), reference.end());
+                for (size_t threads : { 1, 4 }) {
+                    auto v = original;
+                    auto pivot = algs::sort::parallel::partition(v.begin(), v.end(), threads);
+                    ASSERT_EQ(*pivot, original.front()) << input.name;
+                    ASSERT_TRUE(algs::sort::quicksort::is_partitioned(v.begin(), pivot, v.end())) << input.name;
+                    std::sort(v.begin(), v.end());
+                    ASSERT_EQ(v, reference) << input.name;
+                }
+            }
+        }
+    }
+
+    TEST(Sort, Parallel_Partition_Deque) {
+        const size_t size = 1 << 18;
+        std::deque<int> v(size);
+        fill_container(v.begin(), v.end());
+        auto pivot = algs::sort::parallel::partition(v.begin(), v.end(), 4);
+        ASSERT_TRUE(algs::sort::quicksort::is_partitioned(v.begin(), pivot, v.end()));
+    }
+
+    TEST(Sort, Parallel_CoRank) {
+        // every split of every merge of small collections with duplicates
+        std::vector<int> left = { 0, 1, 1, 2, 4, 4, 4 }, right = { 1, 1, 3, 4, 5 };
+        for (size_t left_size = 0; left_size <= left.size(); ++left_size) {
+            for (size_t right_size = 0; right_size <= right.size(); ++right_size) {
+                // merged elements are tagged with their origin, left first on ties
+                std::vector<std::pair<int, int>> merged;
+                for (size_t i = 0; i < left_size; ++i)
+                    merged.emplace_back(left[i], 0);
+                for (size_t j = 0; j < right_size; ++j)
+                    merged.emplace_back(right[j], 1);
+                std::stable_sort(merged.begin(), merged.end(),
+                    [](const auto& a, const auto& b) { return a.first < b.first; });
+                size_t from_left = 0;
+                for (size_t k = 0; k <= merged.size(); ++k) {
+                    auto [i, j] = algs::sort::parallel::co_rank(k, left.begin(), left.begin() + left_size,
+                        right.begin(), right.begin() + right_size);
+                    ASSERT_EQ(i, from_left) << "k " << k;
+                    ASSERT_EQ(i + j, k);
+                    if (k < merged.size() && merged[k].second == 0)
+                        ++from_left;
+                }
+            }
+        }
+    }
+
+    TEST(Sort, Parallel_MergeMove) {
+        // large enough for several parts
+        for (size_t size : { size_t(0), size_t(1), size_t(1000), size_t(1) << 18 }) {
+            std::vector<int> left(size), right(size / 3);
+            fill_container(left.begin(), left.end(), 0, 100);
+            fill_container(right.begin(), right.end(), 0, 100);
+            std::sort(left.begin(), left.end());
+            std::sort(right.begin(), right.end());
+            std::vector<int> reference;
+            std::merge(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(reference));
+            for (size_t threads : { 1, 3, 4 }) {
+                std::vector<int> out(left.size() + right.size());
+                algs::sort::parallel::merge_move(left.begin(), left.end(), right.begin(), right.end(),
+                    out.begin(), threads);
+                ASSERT_EQ(out, reference);
+            }
+        }
+    }
+
+    TEST(Sort, Parallel_MergeSort) {
+        using Iter = std::vector<int>::iterator;
+        for (const auto& input : helpers::inputs<Iter>()) {
+            // large enough for forked halves and split merges
+            for (size_t size : { size_t(0), size_t(1), size_t(1000), size_t(1) << 18 }) {
+                std::vector<int> original(size);
+                fill_container(original.begin(), original.end(), input);
+                auto reference = original;
+                std::sort(reference.begin(), reference.end());
+                for (size_t threads : { 1, 3, 4 }) {
+                    auto v = original;
+                    algs::sort::parallel::merge_sort(v.begin(), v.end(), threads);
+                    ASSERT_EQ(v, reference) << input.name << ", size " << size << ", threads " << threads;
+                }
+            }
+        }
+    }
+
+    TEST(Sort, Parallel_MergeSort_Stable) {
+        // few keys, so equal keys are split between threads
+        const size_t size = 1 << 18;
+        std::vector<int> keys(size);
+        fill_container(keys.begin(), keys.end(), 0, 10);
+        std::vector<std::pair<int, size_t>> v(size);
+        for (size_t i = 0; i < size; ++i)
+            v[i] = { keys[i], i };
+        auto reference = v;
+        std::sort(reference.begin(), reference.end());
+
+        struct by_key {
+            std::pair<int, size_t> value;
+            bool operator<(const by_key& other) const { return value.first < other.value.first; }
+        };
+        std::vector<by_key> sorted(size);
+        std::transform(v.begin(), v.end(), sorted.begin(), [](const auto& value) { return by_key{ value }; });
+        algs::sort::scratch_buffer<by_key> scratch;
+        algs::sort::parallel::merge_sort(sorted.begin(), sorted.end(), scratch, 4);
+        for (size_t i = 0; i < size; ++i)
+            ASSERT_EQ(sorted[i].value, reference[i]) << i;
+        ASSERT_GE(scratch.capacity(), size);
+    }
+}
@@ -1,9 +1,171 @@
 #include "common.hpp"
 #include "algs/sort/quicksort.hpp"
 #include "algs/sort/shuffle.hpp"
+#include "helpers/stack_depth.hpp"
+
+#include <numeric>
 
 namespace {
     REGISTER_TESTS(Sort, Quicksort_Sort, algs::sort::quicksort::sort)
+    REGISTER_TESTS(Sort, Quicksort_Introsort, algs::sort::quicksort::introsort)
+    REGISTER_TESTS(Sort, Quicksort_SortThreeWay, algs::sort::quicksort::sort_three_way)
+    REGISTER_TESTS(Sort, Quicksort_Pdqsort, algs::sort::quicksort::pdqsort)
+    REGISTER_TESTS(Sort, Quicksort_SortDualPivot, algs::sort::quicksort::sort_dual_pivot)
+
+    TEST(Sort, Quicksort_Sort_Antiqsort) {
+        using Iter = std::vector<helpers::antiqsort::item>::iterator;
+        for (size_t size : { 64, 256, 1024 }) {
+            helpers::antiqsort adversary(size);
+            auto items = adversary.items();
+            algs::sort::quicksort::sort(items.begin(), items.end());
+            // first element pivots make every partition lopsided
+            ASSERT_GE(adversary.comparisons(), size * size / 2);
+
+            // replaying the input forces the same comparisons
+            auto values = helpers::antiqsort_input<helpers::counted<int>>(
+                size, algs::sort::quicksort::sort<Iter>);
+            auto counts = helpers::count_operations<int>(
+                [&] { algs::sort::quicksort::sort(values.begin(), values.end()); });
+            ASSERT_EQ(counts.comparisons, adversary.comparisons());
+            for (size_t i = 0; i < size; ++i)
+                ASSERT_EQ(values[i].value(), int(i));
+        }
+    }
+
+    TEST(Sort, Quicksort_Sort_StackDepth) {
+        using Container = std::vector<helpers::probed<int>>;
+        const size_t size = MAX_CONTAINER_SIZE;
+        std::vector<int> original(size);
+        fill_container(original.begin(), original.end());
+        Container random(original.begin(), original.end());
+        auto random_bytes = helpers::stack_depth::measure(
+            [&] { algs::sort::quicksort::sort(random.begin(), random.end()); });
+        std::sort(original.begin(), original.end());
+        Container sorted(original.begin(), original.end());
+        auto sorted_bytes = helpers::stack_depth::measure(
+            [&] { algs::sort::quicksort::sort(sorted.begin(), sorted.end()); });
+        // NOTE: recursion is as deep as input size on sorted input
+        ASSERT_GT(sorted_bytes, size * sizeof(void *));
+        ASSERT_GT(sorted_bytes, 10 * random_bytes);
+    }
+
+    TEST(Sort, Quicksort_Sort_Observer) {
+        const size_t size = 1000;
+        // NOTE: not a vector, vectorized partitioning reorders the greater part
+        std::deque<int> v(size);
+        std::iota(v.begin(), v.end(), 0);
+        algs::sort::trace_observer trace(16);
+        algs::sort::quicksort::sort(v.begin(), v.end(), trace);
+
+        // first element pivots on sorted input: a partition per level
+        ASSERT_EQ(trace.max_depth(), size);
+        ASSERT_EQ(trace.events().size(), 16u);
+        ASSERT_EQ(trace.dropped(), size - 16);
+        for (size_t i = 0; i < trace.events().size(); ++i) {
+            const auto& e = trace.events()[i];
+            ASSERT_EQ(e.kind, algs::sort::trace_observer::PARTITION);
+            ASSERT_EQ(e.depth, i + 1);
+            ASSERT_EQ(e.first, 0u);
+            ASSERT_EQ(e.second, size - i - 1);
+        }
+    }
+
+    TEST(Sort, Quicksort_Select_Observer) {
+        const size_t size = 1000;
+        std::vector<int> v(size);
+        fill_container(v.begin(), v.end(), 0, int(size));
+        auto reference = v;
+        std::sort(reference.begin(), reference.end());
+        algs::sort::trace_observer trace;
+        auto it = algs::sort::quicksort::select(v.begin(), v.end(), size / 2, trace);
+        ASSERT_EQ(*it, reference[size / 2]);
+        ASSERT_GT(trace.events().size(), 0u);
+        ASSERT_EQ(trace.max_depth(), 0u);
+        ASSERT_EQ(trace.events().front().first + trace.events().front().second, size - 1);
+    }
+
+    TEST(Sort, Quicksort_Introsort_Antiqsort) {
+        using Iter = std::vector<helpers::antiqsort::item>::iterator;
+        for (size_t size : { 1024, 16384 }) {
+            helpers::antiqsort adversary(size);
+            auto items = adversary.items();
+            algs::sort::trace_observer trace(0);
+            algs::sort::quicksort::introsort(items.begin(), items.end(), trace);
+            // heap sort takes over once pivots go bad
+            ASSERT_LE(adversary.comparisons(), 4 * size * size_t(std::log2(size)));
+            ASSERT_LE(trace.max_depth(), size_t(std::log2(size)) + 1);
+
+            auto values = helpers::antiqsort_input<int>(size, algs::sort::quicksort::introsort<Iter>);
+            algs::sort::quicksort::introsort(values.begin(), values.end());
+            for (size_t i = 0; i < size; ++i)
+                ASSERT_EQ(values[i], int(i));
+        }
+    }
+
+    TEST(Sort, Quicksort_Introsort_Observer) {
+        const size_t size = 1 << 16;
+        for (const auto& input : helpers::inputs<std::vector<int>::iterator>()) {
+            std::vector<int> v(size);
+            fill_container(v.begin(), v.end(), input);
+            algs::sort::trace_observer trace;
+            algs::sort::quicksort::introsort(v.begin(), v.end(), trace);
+            ASSERT_TRUE(std::is_sorted(v.begin(), v.end())) << input.name;
+            // recursion goes into the smaller part only
+            ASSERT_LE(trace.max_depth(), size_t(std::log2(size)) + 1) << input.name;
+        }
+    }
+
+    TEST(Sort, Quicksort_Pdqsort_Patterns) {
+        const size_t size = 1 << 16;
+        for (const auto& input : helpers::inputs<std::vector<int>::iterator>()) {
+            std::vector<int> v(size);
+            fill_container(v.begin(), v.end(), input);
+            algs::sort::trace_observer trace;
+            algs::sort::quicksort::pdqsort(v.begin(), v.end(), trace);
+            ASSERT_TRUE(std::is_sorted(v.begin(), v.end())) << input.name;
+            ASSERT_LE(trace.max_depth(), size_t(std::log2(size)) + 1) << input.name;
+            // already partitioned input is finished by insertion sort
+            if (input.fill == helpers::fill_sorted<std::vector<int>::iterator>) {
+                ASSERT_EQ(trace.events().size(), 1u);
+            }
+            // keys equal to the previous pivot are skipped at once
+            if (input.fill == helpers::fill_equal<std::vector<int>::iterator>) {
+                ASSERT_EQ(trace.events().size(), 2u);
+            }
+        }
+    }
+
+    TEST(Sort, Quicksort_Pdqsort_Antiqsort) {
+        using Iter = std::vector<helpers::antiqsort::item>::iterator;
+        for (size_t size : { 1024, 16384 }) {
+            helpers::antiqsort adversary(size);
+            auto items = adversary.items();
+            algs::sort::quicksort::pdqsort(items.begin(), items.end());
+            ASSERT_LE(adversary.comparisons(), 4 * size * size_t(std::log2(size)));
+
+            auto values = helpers::antiqsort_input<int>(size, algs::sort::quicksort::pdqsort<Iter>);
+            algs::sort::quicksort::pdqsort(values.begin(), values.end());
+            for (size_t i = 0; i < size; ++i)
+                ASSERT_EQ(values[i], int(i));
+        }
+    }
+
+    TEST(Sort, Quicksort_SortDualPivot_Observer) {
+        const size_t size = 1 << 16;
+        for (const auto& input : helpers::inputs<std::vector<int>::iterator>()) {
+            std::vector<int> v(size);
+            fill_container(v.begin(), v.end(), input);
+            algs::sort::trace_observer trace;
+            algs::sort::quicksort::sort_dual_pivot(v.begin(), v.end(), trace);
+            ASSERT_TRUE(std::is_sorted(v.begin(), v.end())) << input.name;
+            // recursion goes into two smaller parts only
+            ASSERT_LE(trace.max_depth(), size_t(std::log2(size)) + 1) << input.name;
+            // equal pivots leave no middle part
+            if (input.fill == helpers::fill_equal<std::vector<int>::iterator>) {
+                ASSERT_EQ(trace.events().size(), 1u);
+            }
+        }
+    }
 
     TEST(Sort, Quicksort_IsPartitioned) {
         using algs::sort::quicksort::is_partitioned;
@@ -56,6 +218,28 @@ namespace {
         }
     }
 
+    TEST(Sort, Quicksort_Partition_Block) {
+        using algs::sort::quicksort::partition_block;
+        using algs::sort::quicksort::is_partitioned;
+        using Container = std::vector<int>;
+        using value_type = typename Container::value_type;
+        for (auto size : TEST_CONTAINER_SIZES) {
+            for (int i = 0; i < std::max(1., std::log(size)); ++i) {
+                Container v(size);
+                fill_container(v.begin(), v.end(), value_type(0), value_type(size));
+                // precondition: an element not less than the pivot at the end
+                std::iter_swap(std::max_element(v.begin(), v.end()), std::prev(v.end()));
+                auto part = partition_block(v.begin(), v.end());
+                ASSERT_TRUE(is_partitioned(v.begin(), part.first, v.end()));
+            }
+            Container v(size);
+            std::iota(v.begin(), v.end(), 0);
+            auto part = partition_block(v.begin(), v.end());
+            ASSERT_TRUE(part.second);
+            ASSERT_EQ(part.first, v.begin());
+        }
+    }
+
     TEST(Sort, Quicksort_Select) {
         using algs::sort::shuffle;
         using algs::sort::quicksort::select;
@@ -76,7 +260,104 @@ namespace {
         }
     }
 
-    // TODO: fails very infrequently, check&fix
+    /**
+     * Check that `select(begin, end, k)` puts k-th element in place and
+     * partitions a collection around it, on all input shapes
+     **/
+    template<typename SelectFn>
+    void test_select(SelectFn select) {
+        using Iter = std::vector<int>::iterator;
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        for (const auto& input : helpers::inputs<Iter>()) {
+            for (auto size : { size_t(1), size_t(17), size_t(1000), size_t(20000) }) {
+                std::vector<int> v(size);
+                fill_container(v.begin(), v.end(), input);
+                size_t k = std::uniform_int_distribution<size_t>(0, size - 1)(gen);
+                auto reference = v;
+                std::nth_element(reference.begin(), std::next(reference.begin(), k), reference.end());
+                auto it = select(v.begin(), v.end(), k);
+                ASSERT_EQ(it, std::next(v.begin(), k)) << input.name;
+                ASSERT_EQ(*it, reference[k]) << input.name;
+                ASSERT_TRUE(std::all_of(v.begin(), it, [&](int x) { return x <= *it; })) << input.name;
+                ASSERT_TRUE(std::all_of(it, v.end(), [&](int x) { return *it <= x; })) << input.name;
+                ASSERT_EQ(select(v.begin(), v.end(), size), v.end());
+            }
+        }
+    }
+
+    TEST(Sort, Quicksort_Introselect) {
+        test_select(algs::sort::quicksort::introselect<std::vector<int>::iterator>);
+    }
+
+    TEST(Sort, Quicksort_SelectMedianOfMedians) {
+        test_select(algs::sort::quicksort::select_median_of_medians<std::vector<int>::iterator>);
+    }
+
+    TEST(Sort, Quicksort_SelectFloydRivest) {
+        test_select(algs::sort::quicksort::select_floyd_rivest<std::vector<int>::iterator>);
+    }
+
+    TEST(Sort, Quicksort_Introselect_Antiqsort) {
+        using Iter = std::vector<helpers::antiqsort::item>::iterator;
+        auto median = [](Iter b, Iter e) { algs::sort::quicksort::introselect(b, e, size_t(e - b) / 2); };
+        for (size_t size : { 1000, 10000, 100000 }) {
+            helpers::antiqsort adversary(size);
+            auto items = adversary.items();
+            median(items.begin(), items.end());
+            // median of medians takes over once progress stalls, O(n) anyway
+            ASSERT_LE(adversary.comparisons(), 20 * size);
+        }
+    }
+
+    TEST(Sort, Quicksort_MultiSelect) {
+        using Iter = std::vector<int>::iterator;
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        for (const auto& input : helpers::inputs<Iter>()) {
+            for (size_t size : { 1, 17, 1000, 20000 }) {
+                for (size_t count : { 0, 1, 4, 100 }) {
+                    std::vector<int> v(size);
+                    fill_container(v.begin(), v.end(), input);
+                    std::vector<size_t> ranks(count);
+                    for (auto& rank : ranks) // duplicates and out of range ranks too
+                        rank = std::uniform_int_distribution<size_t>(0, size)(gen);
+                    auto reference = v;
+                    std::sort(reference.begin(), reference.end());
+                    auto result = algs::sort::quicksort::multi_select(v.begin(), v.end(), ranks);
+                    ASSERT_EQ(result.size(), count);
+                    for (size_t i = 0; i < count; ++i) {
+                        if (ranks[i] == size) {
+                            ASSERT_EQ(result[i], v.end());
+                            continue;
+                        }
+                        ASSERT_EQ(result[i], std::next(v.begin(), ranks[i])) << input.name;
+                        ASSERT_EQ(*result[i], reference[ranks[i]]) << input.name;
+                        ASSERT_TRUE(std::all_of(v.begin(), result[i],
+                            [&](int x) { return x <= *result[i]; })) << input.name;
+                        ASSERT_TRUE(std::all_of(result[i], v.end(),
+                            [&](int x) { return *result[i] <= x; })) << input.name;
+                    }
+                }
+            }
+        }
+    }
+
+    TEST(Sort, Quicksort_MultiSelect_Comparisons) {
+        const size_t size = 100000;
+        std::vector<int> original(size);
+        fill_container(original.begin(), original.end());
+        std::vector<helpers::counted<int>> v(original.begin(), original.end());
+        // percentiles p50, p90, p99, p99.9 and a rank per 1/64th
+        std::vector<size_t> ranks = { size / 2, size * 9 / 10, size * 99 / 100, size * 999 / 1000 };
+        for (size_t i = 0; i < 64; ++i)
+            ranks.push_back(size * i / 64);
+        auto counts = helpers::count_operations<int>(
+            [&] { algs::sort::quicksort::multi_select(v.begin(), v.end(), ranks); });
+        // O(n log m), about a selection pass per level of ranks
+        ASSERT_LE(counts.comparisons, 6 * size * size_t(std::log2(ranks.size()) + 1));
+    }
+
     TEST(Sort, Quicksort_Partition_DualPivot) {
         using algs::sort::quicksort::partition_dual_pivot;
         using algs::sort::quicksort::is_partitioned_dual_pivot;
@@ -84,17 +365,18 @@ namespace {
         using value_type = typename Container::value_type;
         for (auto size : TEST_CONTAINER_SIZES) {
             for (int i = 0; i < std::max(1., std::log(size)); ++i) {
-                Container v(size);
-                fill_container(v.begin(), v.end(), value_type(0), value_type(size));
-                auto part = partition_dual_pivot(v.begin(), v.end());
-                ASSERT_TRUE(is_partitioned_dual_pivot(v.begin(), part.first, part.second, v.end()));
+                // few distinct keys make elems equal to pivots common
+                for (auto hi : { value_type(size), value_type(4) }) {
+                    Container v(size);
+                    fill_container(v.begin(), v.end(), value_type(0), hi);
+                    auto part = partition_dual_pivot(v.begin(), v.end());
+                    ASSERT_TRUE(is_partitioned_dual_pivot(v.begin(), part.first, part.second, v.end()));
+                }
             }
         }
     }
 
-    // TODO: fix this
     TEST(Sort, Quicksort_Partition_ThreeWay) {
-        return;
         using algs::sort::quicksort::partition_three_way;
         using algs::sort::quicksort::is_partitioned_dual_pivot;
         using Container = std::vector<int>;
@@ -102,14 +384,24 @@ namespace {
         for (auto size : TEST_CONTAINER_SIZES) {
             for (int i = 0; i < std::max(1., std::log(size)); ++i) {
                 Container v(size);
-                fill_container(v.begin(), v.end(), value_type(0), value_type(size));
-                std::cout << "before: " << v << std::endl;
+                fill_container(v.begin(), v.end(), value_type(0), value_type(std::sqrt(size)));
                 auto part = partition_three_way(v.begin(), v.end());
-                std::cout << "part:   " << (part.first-v.begin()) << " " << (part.second-v.begin()) << std::endl;
-                std::cout << "after:  " << v << std::endl;
                 ASSERT_TRUE(is_partitioned_dual_pivot(v.begin(), part.first, part.second, v.end()));
+                ASSERT_EQ(*part.first, *part.second);
+                ASSERT_EQ(std::count(v.begin(), v.end(), *part.first),
+                    std::distance(part.first, part.second) + 1);
             }
         }
     }
-}
 
+    TEST(Sort, Quicksort_SortThreeWay_FewUnique) {
+        const size_t size = 1 << 16;
+        std::vector<int> v(size);
+        fill_container(v.begin(), v.end(), 0, 15);
+        algs::sort::trace_observer trace;
+        algs::sort::quicksort::sort_three_way(v.begin(), v.end(), trace);
+        ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+        // a partition per distinct key at most
+        ASSERT_LE(trace.events().size(), 16u);
+    }
+}
@@ -0,0 +1,58 @@
+#include "common.hpp"
+#include "algs/sort/scratch.hpp"
+
+#include <string>
+
+namespace {
+    TEST(Sort, Scratch_Reuse) {
+        algs::sort::scratch_buffer<int> scratch;
+        ASSERT_EQ(scratch.capacity(), 0u);
+        int *pData = scratch.get(1000);
+        ASSERT_NE(pData, nullptr);
+        ASSERT_GE(scratch.capacity(), 1000u);
+        std::fill(pData, pData + 1000, 7);
+        // smaller and equal requests reuse the memory
+        ASSERT_EQ(scratch.get(10), pData);
+        ASSERT_EQ(scratch.get(1000), pData);
+        // a larger one grows the buffer
+        pData = scratch.get(5000);
+        ASSERT_GE(scratch.capacity(), 5000u);
+        std::fill(pData, pData + 5000, 7);
+        ASSERT_FALSE(scratch.huge_pages());
+    }
+
+    TEST(Sort, Scratch_NonTrivial) {
+        algs::sort::scratch_buffer<std::string> scratch;
+        std::string *pData = scratch.get(100);
+        for (size_t i = 0; i < 100; ++i) {
+            ASSERT_TRUE(pData[i].empty());
+            pData[i] = std::string(100, 'a'); // heap allocated strings
+        }
+        // constructed elements are kept for reuse and destroyed on growth
+        pData = scratch.get(1000);
+        for (size_t i = 0; i < 1000; ++i)
+            pData[i] = std::to_string(i);
+        ASSERT_EQ(pData[999], "999");
+    }
+
+    TEST(Sort, Scratch_HugePages) {
+        const size_t size = (8 << 20) / sizeof(int64_t);
+        algs::sort::scratch_buffer<int64_t> scratch(true);
+        scratch.reserve(size);
+        // either reserved or transparent huge pages, rounded up to their size
+        ASSERT_GE(scratch.capacity(), size);
+#ifdef __linux__
+        ASSERT_TRUE(scratch.huge_pages());
+        ASSERT_EQ(scratch.capacity() * sizeof(int64_t) % algs::sort::scratch_buffer<int64_t>::HUGE_PAGE_SIZE, 0u);
+#endif
+        int64_t *pData = scratch.get(size);
+        for (size_t i = 0; i < size; ++i)
+            pData[i] = int64_t(i);
+        ASSERT_EQ(pData[size - 1], int64_t(size - 1));
+
+        // small buffers are not worth a huge page
+        algs::sort::scratch_buffer<int64_t> small(true);
+        small.reserve(1000);
+        ASSERT_FALSE(small.huge_pages());
+    }
+}
@@ -3,5 +3,39 @@
 
 namespace {
     REGISTER_TESTS(Sort, Shell_Sort, algs::sort::shell::sort)
-}
 
+    TEST(Sort, Shell_Sort_Counted) {
+        using Container = std::vector<helpers::counted<int>>;
+        for (const auto size : TEST_CONTAINER_SIZES) {
+            Container cont;
+            for (size_t i = 0; i < size; ++i)
+                cont.push_back(int(size - i));
+
+            auto counts = helpers::count_operations<int>([&] {
+                algs::sort::shell::sort(cont.begin(), cont.end());
+            });
+
+            // elements are exchanged instead of shifted
+            ASSERT_GT(counts.swaps, 0u);
+            ASSERT_EQ(counts.moves, 0u);
+            ASSERT_EQ(counts.copies, 0u);
+        }
+    }
+
+    TEST(Sort, Shell_Sort_Observer) {
+        std::vector<int> v(1000);
+        fill_container(v.begin(), v.end());
+        algs::sort::trace_observer trace;
+        algs::sort::shell::sort(v.begin(), v.end(), trace);
+        ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+
+        // passes for h = 364, 121, 40, 13, 4, 1
+        std::vector<size_t> hs;
+        for (const auto& e : trace.events()) {
+            ASSERT_EQ(e.kind, algs::sort::trace_observer::H_PASS);
+            hs.push_back(e.first);
+        }
+        ASSERT_EQ(hs, std::vector<size_t>({ 364, 121, 40, 13, 4, 1 }));
+        ASSERT_EQ(trace.max_depth(), 0u);
+    }
+}
@@ -0,0 +1,88 @@
+#include "common.hpp"
+#include "algs/sort/simd.hpp"
+#include "algs/sort/quicksort.hpp"
+
+#include <cstdint>
+
+namespace {
+    /**
+     * Check `partition(first, last, pivot)` on ranges of every size up to
+     * a few vectors and on random pivots, with few and many distinct keys
+     **/
+    template<typename T, typename PartitionFn>
+    void test_partition(PartitionFn partition) {
+        std::mt19937 gen(42);
+        for (size_t size = 0; size < 200; ++size) {
+            for (int hi : { 4, 1 << 20 }) {
+                std::vector<T> v(size);
+                std::uniform_int_distribution<int> dis(-hi, hi);
+                for (auto& x : v)
+                    x = T(dis(gen));
+                T pivot = T(dis(gen));
+                auto reference = v;
+                auto middle = partition(v.data(), v.data() + v.size(), pivot);
+                for (auto it = v.data(); it != middle; ++it)
+                    ASSERT_FALSE(pivot < *it) << "size " << size;
+                for (auto it = middle; it != v.data() + v.size(); ++it)
+                    ASSERT_TRUE(pivot < *it) << "size " << size;
+                std::sort(v.begin(), v.end());
+                std::sort(reference.begin(), reference.end());
+                ASSERT_EQ(v, reference);
+            }
+        }
+    }
+
+    template<typename T>
+    void test_partition_kernels() {
+        test_partition<T>(algs::sort::simd::partition_scalar<T>);
+        test_partition<T>(algs::sort::simd::partition<T>);
+#if defined(__AVX2__)
+        test_partition<T>(algs::sort::simd::partition_vector<algs::sort::simd::avx2<T>>);
+#endif
+#if defined(__AVX512F__)
+        test_partition<T>(algs::sort::simd::partition_vector<algs::sort::simd::avx512<T>>);
+#endif
+    }
+
+    TEST(Sort, Simd_Partition_Int32) {
+        test_partition_kernels<int32_t>();
+    }
+
+    TEST(Sort, Simd_Partition_Int64) {
+        test_partition_kernels<int64_t>();
+    }
+
+    TEST(Sort, Simd_Partition_Float) {
+        test_partition_kernels<float>();
+    }
+
+    TEST(Sort, Simd_Partition_Double) {
+        test_partition_kernels<double>();
+    }
+
+    TEST(Sort, Simd_IsVectorizable) {
+        using algs::sort::simd::is_vectorizable_v;
+        ASSERT_FALSE(is_vectorizable_v<std::deque<int>::iterator>);
+        ASSERT_FALSE(is_vectorizable_v<std::vector<helpers::counted<int>>::iterator>);
+        ASSERT_FALSE(is_vectorizable_v<std::vector<short>::iterator>);
+#if defined(__AVX2__) || defined(__AVX512F__)
+        ASSERT_TRUE(is_vectorizable_v<std::vector<int>::iterator>);
+        ASSERT_TRUE(is_vectorizable_v<double *>);
+#endif
+    }
+
+    TEST(Sort, Quicksort_Partition_Vectorized) {
+        using algs::sort::quicksort::partition_vectorized;
+        using algs::sort::quicksort::is_partitioned;
+        using Container = std::vector<int>;
+        using value_type = typename Container::value_type;
+        for (auto size : TEST_CONTAINER_SIZES) {
+            for (int i = 0; i < std::max(1., std::log(size)); ++i) {
+                Container v(size);
+                fill_container(v.begin(), v.end(), value_type(0), value_type(size));
+                auto pivot = partition_vectorized(v.begin(), v.end());
+                ASSERT_TRUE(is_partitioned(v.begin(), pivot, v.end()));
+            }
+        }
+    }
+}
@@ -82,5 +82,63 @@ namespace {
             }
         }
     }
-}
 
+    TEST(Tree, AVL_Recursive_Insert_Duplicates) {
+        for (size_t size = 16; size <= 1 << 10; size <<= 1) {
+            std::vector<int> base(size);
+            std::generate(base.begin(), base.end(), [n = 0] () mutable { return n++ % 8; });
+            std::random_device rd;
+            std::mt19937 g(rd());
+            std::shuffle(base.begin(), base.end(), g);
+
+            avl tree;
+            for (size_t i = 0; i < base.size(); ++i) {
+                tree.insert(base[i], int(i));
+                ASSERT_EQ(tree.find(base[i]), std::make_pair(base[i], int(i)));
+                ASSERT_LE(tree.size(), 8u);
+                ASSERT_TRUE(tree.check_links_valid());
+                ASSERT_TRUE(tree.check_is_bst());
+                ASSERT_TRUE(tree.check_is_avl());
+            }
+            ASSERT_EQ(tree.size(), 8u);
+        }
+    }
+
+    TEST(Tree, AVL_Profile) {
+        std::vector<int> base(1 << 12);
+        std::iota(base.begin(), base.end(), 0);
+        std::random_device rd;
+        std::mt19937 g(rd());
+        std::shuffle(base.begin(), base.end(), g);
+
+        avl tree;
+        for (int key : base)
+            tree.insert(key, key);
+        auto profile = tree.profile();
+        ASSERT_EQ(profile.size, base.size());
+        ASSERT_EQ(profile.height, tree.height());
+        ASSERT_EQ(profile.external_path_length, profile.internal_path_length + 2 * base.size());
+        ASSERT_LE(profile.avg_successful_comparisons(), double(profile.height));
+        size_t tagged = 0;
+        for (const auto& tag : profile.tag_histogram) {
+            ASSERT_TRUE(-1 <= tag.first && tag.first <= 1);
+            tagged += tag.second;
+        }
+        ASSERT_EQ(tagged, base.size());
+    }
+
+    TEST(Tree, AVL_MemoryUsage) {
+        avl tree;
+        for (int key = 0; key < 100; ++key)
+            tree.insert(key % 64, key);
+        auto stats = tree.memory_usage();
+        ASSERT_EQ(stats.allocations, 64u);
+        ASSERT_EQ(stats.live_nodes, tree.size());
+        ASSERT_EQ(stats.live_bytes, 64 * sizeof(avl::node_type));
+        ASSERT_EQ(stats.slack_bytes(), stats.usable_bytes - stats.live_bytes);
+        ASSERT_EQ(stats.total_bytes(), sizeof(tree) + stats.usable_bytes + stats.header_bytes);
+
+        tree.clear();
+        ASSERT_EQ(tree.memory_usage().frees, 64u);
+    }
+}
@@ -445,5 +445,61 @@ namespace {
             }
         }
     }
-}
 
+    TEST(Tree, BST_Recursive_Profile) {
+        bst tree;
+        ASSERT_EQ(tree.profile().size, 0u);
+        for (int key : { 4, 2, 6, 1, 3, 5, 7, 8 })
+            tree.insert(key, key);
+        auto profile = tree.profile();
+        ASSERT_EQ(profile.size, 8u);
+        ASSERT_EQ(profile.height, 4u);
+        ASSERT_EQ(profile.depth_histogram, std::vector<size_t>({ 1, 2, 4, 1 }));
+        ASSERT_EQ(profile.internal_path_length, 0u + 2 * 1 + 4 * 2 + 3);
+        ASSERT_EQ(profile.external_path_length, profile.internal_path_length + 2 * 8);
+        ASSERT_EQ(profile.min_null_depth, 3u);
+        ASSERT_DOUBLE_EQ(profile.avg_successful_comparisons(), (13. + 8.) / 8.);
+        ASSERT_DOUBLE_EQ(profile.avg_unsuccessful_comparisons(), 29. / 9.);
+        ASSERT_EQ(profile.worst_successful_comparisons(), 4u);
+        ASSERT_TRUE(profile.tag_histogram.empty());
+
+        // sequential keys degrade a tree to a list
+        bst list;
+        for (int key = 0; key < 100; ++key)
+            list.insert(key, key);
+        profile = list.profile();
+        ASSERT_EQ(profile.height, 100u);
+        ASSERT_EQ(profile.internal_path_length, 99u * 100 / 2);
+        ASSERT_EQ(profile.min_null_depth, 1u);
+    }
+
+    TEST(Tree, BST_Recursive_MemoryUsage) {
+        bst tree;
+        auto empty = tree.memory_usage();
+        ASSERT_EQ(empty.allocations, 0u);
+        ASSERT_EQ(empty.total_bytes(), sizeof(tree));
+
+        for (int key = 0; key < 100; ++key)
+            tree.insert_root(key, key);
+        tree.insert(50, 0); // existing key, no allocation
+        auto stats = tree.memory_usage();
+        ASSERT_EQ(stats.allocations, 100u);
+        ASSERT_EQ(stats.frees, 0u);
+        ASSERT_EQ(stats.live_nodes, tree.size());
+        ASSERT_EQ(stats.node_bytes, sizeof(bst::node_type));
+        ASSERT_EQ(stats.live_bytes, 100 * sizeof(bst::node_type));
+        ASSERT_GE(stats.usable_bytes, stats.live_bytes);
+        ASSERT_GE(stats.bytes_per_node(), double(sizeof(bst::node_type)));
+
+        for (int key = 0; key < 100; key += 2)
+            tree.remove(key);
+        stats = tree.memory_usage();
+        ASSERT_EQ(stats.frees, 50u);
+        ASSERT_EQ(stats.live_nodes, tree.size());
+
+        tree.clear();
+        stats = tree.memory_usage();
+        ASSERT_EQ(stats.allocations, stats.frees);
+        ASSERT_EQ(stats.usable_bytes, 0u);
+    }
+}
@@ -2,4 +2,5 @@
 #include <iostream>
 #include <random>
 #include <algorithm>
+#include <numeric>
 